@@ -0,0 +1,74 @@
+#include "arena.h"
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+// Bloques que crecen al doble hasta 1 MB: pocos bloques aun en ASTs grandes
+static const size_t MAX_BLOCK = 1 << 20;
+
+void* Arena::allocateSlow(size_t n, size_t align) {
+    size_t size = max(nextBlockSize, n + align);
+    char* block = (char*)malloc(size);
+    if (!block) throw bad_alloc();
+    blocks.push_back(block);
+    ptr = block;
+    end = block + size;
+    nextBlockSize = min(nextBlockSize * 2, MAX_BLOCK);
+    return allocate(n, align);
+}
+
+string_view Arena::copy(string_view s) {
+    if (s.empty()) return string_view();
+    char* p = (char*)allocate(s.size(), 1);
+    memcpy(p, s.data(), s.size());
+    return string_view(p, s.size());
+}
+
+void Arena::release() {
+    for (char* block : blocks) {
+        free(block);
+    }
+    blocks.clear();
+    ptr = end = nullptr;
+    allocations = 0;
+    bytes = 0;
+}
+
+void Arena::reset() {
+    // Tras absorb() el ultimo bloque puede no ser el actual
+    if (blocks.empty() || ptr < blocks.back() || ptr > end) {
+        release();
+        return;
+    }
+    char* last = blocks.back();
+    size_t size = end - last;
+    blocks.pop_back();
+    release();
+    blocks.push_back(last);
+    ptr = last;
+    end = last + size;
+}
+
+void Arena::absorb(Arena& other) {
+    blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+    allocations += other.allocations;
+    bytes += other.bytes;
+    other.blocks.clear();
+    other.ptr = other.end = nullptr;
+    other.allocations = 0;
+    other.bytes = 0;
+}
+
+Arena*& Arena::currentSlot() {
+    static thread_local Arena* slot = nullptr;
+    return slot;
+}
+
+Arena& Arena::current() {
+    Arena* a = currentSlot();
+    if (a) return *a;
+    static Arena global;
+    return global;
+}
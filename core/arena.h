@@ -0,0 +1,110 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+// Asignador por bloques (bump allocator). Todo lo reservado se libera de una
+// vez al destruir el arena o con release(); no hay delete individual.
+class Arena {
+private:
+    char* ptr = nullptr;
+    char* end = nullptr;
+    vector<char*> blocks;
+    size_t nextBlockSize;
+    size_t allocations = 0;
+    size_t bytes = 0;
+
+    void* allocateSlow(size_t n, size_t align);
+
+public:
+    explicit Arena(size_t firstBlock = 1 << 16) : nextBlockSize(firstBlock) { }
+    ~Arena() { release(); }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t n, size_t align = alignof(max_align_t)) {
+        uintptr_t p = ((uintptr_t)ptr + align - 1) & ~(uintptr_t)(align - 1);
+        if (ptr == nullptr || p + n > (uintptr_t)end) {
+            return allocateSlow(n, align);
+        }
+        ptr = (char*)(p + n);
+        allocations++;
+        bytes += n;
+        return (void*)p;
+    }
+
+    // Copia el texto dentro del arena (queda valido mientras viva el arena)
+    string_view copy(string_view s);
+
+    void release();
+
+    // Libera todo menos el ultimo bloque, que se reutiliza desde el inicio:
+    // un arena que se vacia en cada iteracion no vuelve a pedir memoria
+    void reset();
+
+    // Se queda con los bloques de other (que queda vacio): lo reservado alla
+    // vive hasta que se libere este arena. Une los ASTs parseados en paralelo.
+    void absorb(Arena& other);
+
+    size_t allocationCount() const { return allocations; }
+    size_t bytesUsed() const { return bytes; }
+    size_t blockCount() const { return blocks.size(); }
+
+    // Arena en el que se crean los nodos del AST en este hilo. Si nadie
+    // instalo uno con ArenaScope se usa un arena global del proceso.
+    static Arena& current();
+    static Arena*& currentSlot();
+};
+
+// Instala un arena como Arena::current() mientras dure el scope
+class ArenaScope {
+private:
+    Arena* previous;
+
+public:
+    explicit ArenaScope(Arena& arena) : previous(Arena::currentSlot()) {
+        Arena::currentSlot() = &arena;
+    }
+    ~ArenaScope() { Arena::currentSlot() = previous; }
+};
+
+// Allocator STL sobre un Arena: los contenedores hijos de los nodos tambien
+// viven en el arena y no necesitan destructor.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+    Arena* arena;
+
+    ArenaAllocator() : arena(&Arena::current()) { }
+    ArenaAllocator(Arena& a) : arena(&a) { }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) { }
+
+    T* allocate(size_t n) { return (T*)arena->allocate(n * sizeof(T), alignof(T)); }
+    void deallocate(T*, size_t) { }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template <typename T>
+using ArenaList = list<T, ArenaAllocator<T>>;
+
+template <typename T>
+using ArenaVector = vector<T, ArenaAllocator<T>>;
+
+// Base de los nodos del AST: new reserva en Arena::current(), delete no hace nada
+struct ArenaNode {
+    static void* operator new(size_t n) { return Arena::current().allocate(n); }
+    static void operator delete(void*) { }
+};
+
+#endif // ARENA_H
@@ -5,17 +5,15 @@
 using namespace std;
 
 // ------------------ TypeDecl ------------------
-TypeDecl::TypeDecl(TypeKind k, string n) : kind(k), name(n) {}
-
-TypeDecl::~TypeDecl() {}
+TypeDecl::TypeDecl(TypeKind k, string_view n) : kind(k), name(n) {}
 
 string TypeDecl::toString() const {
     switch (kind) {
         case INT_TYPE: return "int";
-        case UNSIGNED_TYPE: return "unsigned " + name;
+        case UNSIGNED_TYPE: return "unsigned " + string(name);
         case FLOAT_TYPE: return "float";
-        case STRUCT_TYPE: return "struct " + name;
-        case ID_TYPE: return name;
+        case STRUCT_TYPE: return "struct " + string(name);
+        case ID_TYPE: return string(name);
         default: return "unknown";
     }
 }
@@ -39,66 +37,14 @@ string Exp::binopToChar(BinaryOp op) {
 }
 
 // ------------------ BinaryExp ------------------
-BinaryExp::BinaryExp(Exp* l, Exp* r, BinaryOp o) : left(l), right(r), op(o) {}
-
-BinaryExp::~BinaryExp() {
-    delete left;
-    delete right;
-}
+BinaryExp::BinaryExp(Exp* l, Exp* r, BinaryOp o) : Exp(KIND), left(l), right(r), op(o) {}
 
 int BinaryExp::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
-bool BinaryExp::isConstant(int& value) const {
-    int lv, rv;
-    if (!left->isConstant(lv) || !right->isConstant(rv)) {
-        return false;
-    }
-
-    switch (op) {
-        case PLUS_OP:
-            value = lv + rv;
-            return true;
-        case MINUS_OP:
-            value = lv - rv;
-            return true;
-        case MUL_OP:
-            value = lv * rv;
-            return true;
-        case DIV_OP:
-            if (rv == 0) return false;
-            value = lv / rv;
-            return true;
-        case LT_OP:
-            value = (lv < rv) ? 1 : 0;
-            return true;
-        case LE_OP:
-            value = (lv <= rv) ? 1 : 0;
-            return true;
-        case GT_OP:
-            value = (lv > rv) ? 1 : 0;
-            return true;
-        case GE_OP:
-            value = (lv >= rv) ? 1 : 0;
-            return true;
-        case EQ_OP:
-            value = (lv == rv) ? 1 : 0;
-            return true;
-        case NE_OP:
-            value = (lv != rv) ? 1 : 0;
-            return true;
-
-        default:
-            return false;
-    }
-}
-
-
 // ------------------ NumberExp ------------------
-NumberExp::NumberExp(int v) : value(v) {}
-
-NumberExp::~NumberExp() {}
+NumberExp::NumberExp(int v) : Exp(KIND), value(v) {}
 
 int NumberExp::accept(Visitor* visitor) {
     return visitor->visit(this);
@@ -110,27 +56,21 @@ bool NumberExp::isConstant(int& value) const {
 }
 
 // ------------------ FloatExp ------------------
-FloatExp::FloatExp(float v) : value(v) {}
-
-FloatExp::~FloatExp() {}
+FloatExp::FloatExp(double v) : Exp(KIND), value(v) {}
 
 int FloatExp::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ IdExp ------------------
-IdExp::IdExp(string v) : value(v) {}
-
-IdExp::~IdExp() {}
+IdExp::IdExp(string_view v, SymbolId sym) : Exp(KIND), value(v), sym(sym) {}
 
 int IdExp::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ BoolExp ------------------
-BoolExp::BoolExp(bool v) : value(v) {}
-
-BoolExp::~BoolExp() {}
+BoolExp::BoolExp(bool v) : Exp(KIND), value(v) {}
 
 int BoolExp::accept(Visitor* visitor) {
     return visitor->visit(this);
@@ -142,51 +82,28 @@ bool BoolExp::isConstant(int& value) const {
 }
 
 // ------------------ StringExp ------------------
-StringExp::StringExp(string v) : value(v) {}
-
-StringExp::~StringExp() {}
+StringExp::StringExp(string_view v, SymbolId sym) : Exp(KIND), value(v), sym(sym) {}
 
 int StringExp::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ FcallExp ------------------
-FcallExp::FcallExp(string fname) : fname(fname) {}
-
-FcallExp::~FcallExp() {
-    for (Exp* arg : args) {
-        delete arg;
-    }
-}
+FcallExp::FcallExp(string_view fname, SymbolId sym) : Exp(KIND), fname(fname), sym(sym) {}
 
 int FcallExp::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ VarDec ------------------
-VarDec::VarDec(TypeDecl* t) : type(t) {}
-
-VarDec::~VarDec() {
-    delete type;
-    for (auto& var : vars) {
-        if (var.init_value) {
-            delete var.init_value;
-        }
-    }
-}
+VarDec::VarDec(TypeDecl* t) : Stm(KIND), type(t) {}
 
 int VarDec::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ StructDec ------------------
-StructDec::StructDec(string n) : name(n) {}
-
-StructDec::~StructDec() {
-    for (auto field : fields) {
-        delete field;
-    }
-}
+StructDec::StructDec(string_view n) : name(n) {}
 
 int StructDec::accept(Visitor* visitor) {
     return visitor->visit(this);
@@ -195,38 +112,19 @@ int StructDec::accept(Visitor* visitor) {
 // ------------------ Body ------------------
 Body::Body() {}
 
-Body::~Body() {
-    for (auto vd : vardecs) {
-        delete vd;
-    }
-    for (auto stm : stmts) {
-        delete stm;
-    }
-}
-
 int Body::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ AssignStm ------------------
-AssignStm::AssignStm(string id, Exp* rhs) : id(id), rhs(rhs) {}
-
-AssignStm::~AssignStm() {
-    delete rhs;
-}
+AssignStm::AssignStm(string_view id, SymbolId sym, Exp* rhs) : Stm(KIND), id(id), sym(sym), rhs(rhs) {}
 
 int AssignStm::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ PrintStm ------------------
-PrintStm::PrintStm() {}
-
-PrintStm::~PrintStm() {
-    for (auto arg : args) {
-        delete arg;
-    }
-}
+PrintStm::PrintStm() : Stm(KIND) {}
 
 int PrintStm::accept(Visitor* visitor) {
     return visitor->visit(this);
@@ -234,13 +132,7 @@ int PrintStm::accept(Visitor* visitor) {
 
 // ------------------ IfStm ------------------
 IfStm::IfStm(Exp* condition, Body* thenbody, Body* elsebody) 
-    : condition(condition), thenbody(thenbody), elsebody(elsebody) {}
-
-IfStm::~IfStm() {
-    delete condition;
-    delete thenbody;
-    delete elsebody;
-}
+    : Stm(KIND), condition(condition), thenbody(thenbody), elsebody(elsebody) {}
 
 int IfStm::accept(Visitor* visitor) {
     return visitor->visit(this);
@@ -248,25 +140,14 @@ int IfStm::accept(Visitor* visitor) {
 
 // ------------------ TernaryExp ------------------
 TernaryExp::TernaryExp(Exp* condition, Exp* thenExp, Exp* elseExp)
-    : condition(condition), thenExp(thenExp), elseExp(elseExp) {}
-
-TernaryExp::~TernaryExp() {
-    delete condition;
-    delete thenExp;
-    delete elseExp;
-}
+    : Exp(KIND), condition(condition), thenExp(thenExp), elseExp(elseExp) {}
 
 int TernaryExp::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ WhileStm ------------------
-WhileStm::WhileStm(Exp* condition, Body* body) : condition(condition), body(body) {}
-
-WhileStm::~WhileStm() {
-    delete condition;
-    delete body;
-}
+WhileStm::WhileStm(Exp* condition, Body* body) : Stm(KIND), condition(condition), body(body) {}
 
 int WhileStm::accept(Visitor* visitor) {
     return visitor->visit(this);
@@ -274,53 +155,31 @@ int WhileStm::accept(Visitor* visitor) {
 
 // ------------------ ForStm ------------------
 ForStm::ForStm(Stm* init, Exp* condition, AssignStm* update, Body* body)
-    : init(init), condition(condition), update(update), body(body) {}
-
-ForStm::~ForStm() {
-    delete init;
-    delete condition;
-    delete update;
-    delete body;
-}
+    : Stm(KIND), init(init), condition(condition), update(update), body(body) {}
 
 int ForStm::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ ReturnStm ------------------
-ReturnStm::ReturnStm(Exp* expr) : expr(expr) {}
-
-ReturnStm::~ReturnStm() {
-    delete expr;
-}
+ReturnStm::ReturnStm(Exp* expr) : Stm(KIND), expr(expr) {}
 
 int ReturnStm::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ FcallStm ------------------
-FcallStm::FcallStm(FcallExp* fcall) : fcall(fcall) {}
-
-FcallStm::~FcallStm() {
-    delete fcall;
-}
+FcallStm::FcallStm(FcallExp* fcall) : Stm(KIND), fcall(fcall) {}
 
 int FcallStm::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
 
 // ------------------ FunDec ------------------
-FunDec::FunDec(TypeDecl* rtype, string name, vector<TypeDecl*> ptypes, 
-               vector<string> pnames, Body* body)
-    : rtype(rtype), name(name), ptypes(ptypes), pnames(pnames), body(body) {}
-
-FunDec::~FunDec() {
-    delete rtype;
-    for (auto ptype : ptypes) {
-        delete ptype;
-    }
-    delete body;
-}
+FunDec::FunDec(TypeDecl* rtype, string_view name, SymbolId sym, ArenaVector<TypeDecl*> ptypes, 
+               ArenaVector<string_view> pnames, ArenaVector<SymbolId> psyms, Body* body)
+    : rtype(rtype), name(name), sym(sym), ptypes(move(ptypes)), pnames(move(pnames)),
+      psyms(move(psyms)), body(body) {}
 
 int FunDec::accept(Visitor* visitor) {
     return visitor->visit(this);
@@ -329,18 +188,6 @@ int FunDec::accept(Visitor* visitor) {
 // ------------------ Program ------------------
 Program::Program() {}
 
-Program::~Program() {
-    for (auto vd : vardecs) {
-        delete vd;
-    }
-    for (auto sd : structdecs) {
-        delete sd;
-    }
-    for (auto fd : fundecs) {
-        delete fd;
-    }
-}
-
 int Program::accept(Visitor* visitor) {
     return visitor->visit(this);
 }
\ No newline at end of file
@@ -5,10 +5,22 @@
 #include <list>
 #include <ostream>
 #include <vector>
+#include <cstdint>
+#include <string_view>
+#include "arena.h"
+#include "symbols.h"
 using namespace std;
 
 class Visitor;
 
+// Los nodos se reservan en Arena::current() (ver Parser) y se liberan todos
+// juntos con el arena: no hay destructores recursivos. Los nombres son
+// string_view sobre la tabla de simbolos global (o el arena), y los que usa
+// el codegen llevan ademas su SymbolId.
+//
+// Exp y Stm guardan su tipo concreto en kind: los pasos de analisis lo
+// consultan con switch o con as<T>() en lugar de dynamic_cast.
+
 enum BinaryOp {
     PLUS_OP,
     MINUS_OP,
@@ -23,7 +35,18 @@ enum BinaryOp {
     NE_OP
 };
 
-class TypeDecl {
+// Tipo resuelto de una expresion. Lo anota TypeCheckerVisitor y el codegen
+// solo lo lee: un FLOAT_VALUE queda en %xmm0, el resto en %rax.
+enum ValueType : uint8_t {
+    INT_VALUE,
+    UNSIGNED_VALUE,
+    FLOAT_VALUE,
+    BOOL_VALUE,
+    STRING_VALUE,
+    STRUCT_VALUE
+};
+
+class TypeDecl : public ArenaNode {
 public:
     enum TypeKind {
         INT_TYPE,
@@ -34,16 +57,24 @@ public:
     };
     
     TypeKind kind;
-    string name;
+    string_view name;
     
-    TypeDecl(TypeKind k, string n = "");
+    TypeDecl(TypeKind k, string_view n = "");
     string toString() const;
-    ~TypeDecl();
 };
 
 
-class Exp {
+class Exp : public ArenaNode {
 public:
+    enum Kind : uint8_t {
+        BINARY_EXP, NUMBER_EXP, FLOAT_EXP, ID_EXP, BOOL_EXP, STRING_EXP, FCALL_EXP, TERNARY_EXP
+    };
+    const Kind kind;
+    ValueType type = INT_VALUE; // lo completa el TypeChecker
+    uint32_t pos = 0; // offset en el fuente
+    explicit Exp(Kind kind) : kind(kind) {}
+    // El nodo como T, o nullptr si es de otro tipo
+    template <typename T> T* as() { return kind == T::KIND ? static_cast<T*>(this) : nullptr; }
     virtual int accept(Visitor* visitor) = 0;
     virtual ~Exp() {}
     static string binopToChar(BinaryOp op);
@@ -53,177 +84,201 @@ public:
 
 class BinaryExp : public Exp {
 public:
+    static const Kind KIND = BINARY_EXP;
     Exp* left;
     Exp* right;
     BinaryOp op;
+
+    // Lo que RangeAnalysis probo para todas las veces que se evalua el nodo
+    enum Fact : uint8_t {
+        ANALYZED     = 1,
+        FITS_32      = 2,  // resultado en [0, UINT32_MAX]; en / tambien los operandos
+        NON_NEGATIVE = 4,  // los dos operandos >= 0
+        ALWAYS_TRUE  = 8,  // comparacion resuelta; los operandos no tienen
+        ALWAYS_FALSE = 16  // llamadas ni divisiones que puedan fallar
+    };
+    uint8_t facts = 0;
     
     BinaryExp(Exp* l, Exp* r, BinaryOp o);
     int accept(Visitor* visitor);
-    ~BinaryExp();
-    bool isConstant(int& value) const override;
 };
 
 class NumberExp : public Exp {
 public:
+    static const Kind KIND = NUMBER_EXP;
     int value;
     
     NumberExp(int v);
     int accept(Visitor* visitor);
-    ~NumberExp();
 
     bool isConstant(int& value) const override;
 };
 
 class FloatExp : public Exp {
 public:
-    float value;
+    static const Kind KIND = FLOAT_EXP;
+    double value;
     
-    FloatExp(float v);
+    FloatExp(double v);
     int accept(Visitor* visitor);
-    ~FloatExp();
 };
 
 class IdExp : public Exp {
 public:
-    string value;
+    static const Kind KIND = ID_EXP;
+    string_view value;
+    SymbolId sym;
     
-    IdExp(string v);
+    IdExp(string_view v, SymbolId sym);
     int accept(Visitor* visitor);
-    ~IdExp();
 };
 
 class BoolExp : public Exp {
 public:
+    static const Kind KIND = BOOL_EXP;
     bool value;
     
     BoolExp(bool v);
     int accept(Visitor* visitor);
-    ~BoolExp();
 
     bool isConstant(int& value) const override;
 };
 
 class StringExp : public Exp {
 public:
-    string value;
+    static const Kind KIND = STRING_EXP;
+    string_view value;
+    SymbolId sym;
     
-    StringExp(string v);
+    StringExp(string_view v, SymbolId sym);
     int accept(Visitor* visitor);
-    ~StringExp();
 };
 
 class FcallExp : public Exp {
 public:
-    string fname;
-    vector<Exp*> args;
+    static const Kind KIND = FCALL_EXP;
+    string_view fname;
+    SymbolId sym;
+    ArenaVector<Exp*> args;
     
-    FcallExp(string fname);
+    FcallExp(string_view fname, SymbolId sym);
     int accept(Visitor* visitor);
-    ~FcallExp();
 };
 
-class Stm {
+class Stm : public ArenaNode {
 public:
+    enum Kind : uint8_t {
+        VAR_DEC, ASSIGN_STM, PRINT_STM, IF_STM, WHILE_STM, FOR_STM, RETURN_STM, FCALL_STM
+    };
+    const Kind kind;
+    uint32_t pos = 0; // offset en el fuente
+    explicit Stm(Kind kind) : kind(kind) {}
+    template <typename T> T* as() { return kind == T::KIND ? static_cast<T*>(this) : nullptr; }
     virtual int accept(Visitor* visitor) = 0;
     virtual ~Stm() {}
 };
 
 class VarDec : public Stm {
 public:
+    static const Kind KIND = VAR_DEC;
     TypeDecl* type;
 
     struct VarInit {
-        string name;
+        string_view name;
+        SymbolId sym;
         Exp* init_value; 
+        int slot = 0; // offset en el marco (FrameLayout)
         
-        VarInit(string n, Exp* init = nullptr) : name(n), init_value(init) {}
+        VarInit(string_view n, SymbolId s, Exp* init = nullptr) : name(n), sym(s), init_value(init) {}
     };
     
-    list<VarInit> vars;
+    ArenaList<VarInit> vars;
     
     VarDec(TypeDecl* t);
     int accept(Visitor* visitor);
-    ~VarDec();
 
-    void addVar(string name, Exp* init_value = nullptr) {
-        vars.emplace_back(name, init_value);
+    void addVar(string_view name, SymbolId sym, Exp* init_value = nullptr) {
+        vars.emplace_back(name, sym, init_value);
     }
 };
 
 
-class StructDec {
+class StructDec : public ArenaNode {
 public:
-    string name;
-    list<VarDec*> fields;
+    uint32_t pos = 0;
+    string_view name;
+    ArenaList<VarDec*> fields;
     
-    StructDec(string n);
+    StructDec(string_view n);
     int accept(Visitor* visitor);
-    ~StructDec();
 };
 
-class Body {
+class Body : public ArenaNode {
 public:
-    list<VarDec*> vardecs;
-    list<Stm*> stmts;
+    uint32_t pos = 0;
+    ArenaList<VarDec*> vardecs;
+    ArenaList<Stm*> stmts;
     
     Body();
     int accept(Visitor* visitor);
-    ~Body();
 };
 
 class AssignStm : public Stm {
 public:
-    string id;
+    static const Kind KIND = ASSIGN_STM;
+    string_view id;
+    SymbolId sym;
     Exp* rhs;
+    ValueType target = INT_VALUE; // tipo de la variable asignada (TypeChecker)
     
-    AssignStm(string id, Exp* rhs);
+    AssignStm(string_view id, SymbolId sym, Exp* rhs);
     int accept(Visitor* visitor);
-    ~AssignStm();
 };
 
 class PrintStm : public Stm {
 public:
-    list<Exp*> args;
+    static const Kind KIND = PRINT_STM;
+    ArenaList<Exp*> args;
     
     PrintStm();
     int accept(Visitor* visitor);
-    ~PrintStm();
 };
 
 class IfStm : public Stm {
 public:
+    static const Kind KIND = IF_STM;
     Exp* condition;
     Body* thenbody;
     Body* elsebody;
     
     IfStm(Exp* condition, Body* thenbody, Body* elsebody = nullptr);
     int accept(Visitor* visitor);
-    ~IfStm();
 };
 
 class TernaryExp : public Exp {
 public:
+    static const Kind KIND = TERNARY_EXP;
     Exp* condition;
     Exp* thenExp;
     Exp* elseExp;
 
     TernaryExp(Exp* condition, Exp* thenExp, Exp* elseExp);
     int accept(Visitor* visitor);
-    ~TernaryExp();
 };
 
 class WhileStm : public Stm {
 public:
+    static const Kind KIND = WHILE_STM;
     Exp* condition;
     Body* body;
     
     WhileStm(Exp* condition, Body* body);
     int accept(Visitor* visitor);
-    ~WhileStm();
 };
 
 class ForStm : public Stm {
 public:
+    static const Kind KIND = FOR_STM;
     Stm* init;
     Exp* condition;
     AssignStm* update;
@@ -231,50 +286,50 @@ public:
     
     ForStm(Stm* init, Exp* condition, AssignStm* update, Body* body);
     int accept(Visitor* visitor);
-    ~ForStm();
 };
 
 class ReturnStm : public Stm {
 public:
+    static const Kind KIND = RETURN_STM;
     Exp* expr;
     
     ReturnStm(Exp* expr = nullptr);
     int accept(Visitor* visitor);
-    ~ReturnStm();
 };
 
 class FcallStm : public Stm {
 public:
+    static const Kind KIND = FCALL_STM;
     FcallExp* fcall;
     
     FcallStm(FcallExp* fcall);
     int accept(Visitor* visitor);
-    ~FcallStm();
 };
 
-class FunDec {
+class FunDec : public ArenaNode {
 public:
+    uint32_t pos = 0;
     TypeDecl* rtype;
-    string name;
-    vector<TypeDecl*> ptypes;
-    vector<string> pnames;
+    string_view name;
+    SymbolId sym;
+    ArenaVector<TypeDecl*> ptypes;
+    ArenaVector<string_view> pnames;
+    ArenaVector<SymbolId> psyms;
     Body* body;
     
-    FunDec(TypeDecl* rtype, string name, vector<TypeDecl*> ptypes, 
-           vector<string> pnames, Body* body);
+    FunDec(TypeDecl* rtype, string_view name, SymbolId sym, ArenaVector<TypeDecl*> ptypes, 
+           ArenaVector<string_view> pnames, ArenaVector<SymbolId> psyms, Body* body);
     int accept(Visitor* visitor);
-    ~FunDec();
 };
 
-class Program {
+class Program : public ArenaNode {
 public:
-    list<VarDec*> vardecs;
-    list<StructDec*> structdecs;
-    list<FunDec*> fundecs;
+    ArenaList<VarDec*> vardecs;
+    ArenaList<StructDec*> structdecs;
+    ArenaList<FunDec*> fundecs;
     
     Program();
     int accept(Visitor* visitor);
-    ~Program();
 };
 
 #endif // AST_H
\ No newline at end of file
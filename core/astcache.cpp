@@ -0,0 +1,116 @@
+#include "astcache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+using namespace std;
+
+// Cambia con cada build: un compilador nuevo no reutiliza ASTs de otro
+static const char COMPILER_VERSION[] = "flatast-1 " __DATE__ " " __TIME__;
+
+// Cabecera del archivo; a continuacion va una copia del fuente (rellenada a
+// 8 bytes) y despues el FlatAst serializado
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t sourceSize;
+    uint32_t errorPos;
+    uint32_t errorLen;
+};
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "el FlatAst debe quedar alineado a 8");
+static const uint32_t SNAPSHOT_VERSION = 3;
+
+// Hash de 64 bits por palabras de 8 bytes (no criptografico): solo elige el
+// archivo. Dos fuentes pueden chocar, por eso el snapshot guarda el fuente
+// entero y load() lo compara byte a byte.
+uint64_t AstCache::key(string_view source) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ source.size();
+    auto mix = [&h](uint64_t w) {
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    };
+    for (const char* c = COMPILER_VERSION; *c; c++) {
+        mix((uint8_t)*c);
+    }
+    size_t i = 0;
+    for (; i + 8 <= source.size(); i += 8) {
+        uint64_t w;
+        memcpy(&w, source.data() + i, 8);
+        mix(w);
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, source.data() + i, source.size() - i);
+    mix(tail);
+    return h;
+}
+
+string AstCache::path(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ast", (unsigned long long)key);
+    return dir + "/" + name;
+}
+
+bool AstCache::load(string_view source, FlatAst& ast, Diagnostic& error) {
+    uint64_t k = key(source);
+    string file = path(k);
+    if (access(file.c_str(), R_OK) != 0 || !snapshot.open(file)) {
+        return false;
+    }
+    string_view bytes = snapshot.view();
+    SnapshotHeader header;
+    if (bytes.size() < sizeof(header)) return false;
+    memcpy(&header, bytes.data(), sizeof(header));
+    if (memcmp(header.magic, "FAST", 4) != 0 || header.version != SNAPSHOT_VERSION ||
+        header.key != k || header.sourceSize != source.size()) {
+        return false;
+    }
+    size_t at = sizeof(header);
+    size_t padded = (source.size() + 7) / 8 * 8;
+    if (bytes.size() - at < padded || memcmp(bytes.data() + at, source.data(), source.size()) != 0) {
+        return false;
+    }
+    at += padded;
+    if (header.errorPos != UINT32_MAX && (uint64_t)header.errorPos + header.errorLen > source.size()) {
+        return false;
+    }
+    if (!ast.attach(bytes.data() + at, bytes.size() - at)) {
+        return false;
+    }
+    error.pos = header.errorPos;
+    error.len = header.errorLen;
+    return true;
+}
+
+// Se escribe a un temporal y se renombra: un lector concurrente ve el
+// snapshot completo o ninguno
+bool AstCache::store(string_view source, const FlatAst& ast, Diagnostic error) {
+    SnapshotHeader header;
+    memcpy(header.magic, "FAST", 4);
+    header.version = SNAPSHOT_VERSION;
+    header.key = key(source);
+    header.sourceSize = source.size();
+    header.errorPos = error.pos;
+    header.errorLen = error.len;
+
+    error_code ec;
+    filesystem::create_directories(dir, ec);
+    string file = path(header.key);
+    string tmp = file + ".tmp" + to_string(getpid());
+    {
+        ofstream out(tmp, ios::binary);
+        static const char padding[8] = {};
+        out.write((const char*)&header, sizeof(header));
+        out.write(source.data(), source.size());
+        out.write(padding, (8 - source.size() % 8) % 8);
+        ast.serialize(out);
+        if (!out) {
+            out.close();
+            filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    filesystem::rename(tmp, file, ec);
+    return !ec;
+}
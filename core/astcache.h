@@ -0,0 +1,41 @@
+#ifndef ASTCACHE_H
+#define ASTCACHE_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "flatast.h"
+#include "source.h"
+
+using namespace std;
+
+// Cache en disco de ASTs ya parseados: un snapshot del FlatAst por fuente,
+// en <dir>/<clave>.ast, donde la clave es un hash del fuente y de la version
+// del compilador. El snapshot lleva una copia del fuente y solo es un acierto
+// si coincide byte a byte. En un acierto el archivo se mapea con mmap y las
+// columnas del FlatAst apuntan adentro: no se escanea ni se parsea.
+class AstCache {
+public:
+    // Primer caracter invalido del fuente, para repetir el diagnostico del
+    // scanner sin volver a escanear (pos = UINT32_MAX si no hay)
+    struct Diagnostic {
+        uint32_t pos = UINT32_MAX;
+        uint32_t len = 0;
+    };
+
+    explicit AstCache(string dir) : dir(move(dir)) { }
+
+    static uint64_t key(string_view source);
+
+    // ast queda valido mientras viva este AstCache
+    bool load(string_view source, FlatAst& ast, Diagnostic& error);
+    bool store(string_view source, const FlatAst& ast, Diagnostic error);
+
+private:
+    string dir;
+    SourceBuffer snapshot; // el ultimo cargado
+
+    string path(uint64_t key) const;
+};
+
+#endif // ASTCACHE_H
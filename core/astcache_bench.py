@@ -0,0 +1,98 @@
+import argparse
+import os
+import shutil
+import subprocess
+import statistics
+import sys
+import tempfile
+import time
+
+# Latencia de --ast-cache: para fuentes de varios tamanos compara la
+# compilacion sin cache, en frio (cache vacio: parsea y escribe el snapshot)
+# y en caliente (mapea el snapshot, no escanea ni parsea). Cada numero es la
+# mediana de --repeticiones corridas de ./a.out. Tambien revisa que el
+# ensamblador en caliente sea el mismo que sin cache.
+#
+#   python3 astcache_bench.py [--kb 16,256,1024,4096] [--repeticiones 7]
+
+FUNCION = """int f{n}(int a, int b) {{
+    int c;
+    int d;
+    c = a * {k} + b;
+    d = 0;
+    while (d < c) {{
+        d = d + 3;
+    }}
+    if (c >= 10) {{
+        c = c - 10;
+    }} else {{
+        c = c + d;
+    }}
+    printf("%d %d\\n", c, d);
+    return c > d ? c : d;
+}}
+"""
+
+
+def programa(kb):
+    partes = ["#include <stdio.h>\n"]
+    total = 0
+    n = 0
+    while total < kb * 1024:
+        parte = FUNCION.format(n=n, k=n % 97)
+        partes.append(parte)
+        total += len(parte)
+        n += 1
+    partes.append('int main() {\n    printf("%d\\n", f0(1, 2));\n    return 0;\n}\n')
+    return "".join(partes)
+
+
+def correr(compilador, archivo, extra=()):
+    inicio = time.perf_counter()
+    result = subprocess.run([compilador, *extra, archivo], capture_output=True)
+    segundos = time.perf_counter() - inicio
+    if result.returncode != 0:
+        raise RuntimeError(f"{' '.join(extra) or 'sin cache'}: rc={result.returncode}")
+    return segundos
+
+
+def main():
+    args = argparse.ArgumentParser()
+    args.add_argument("--kb", default="16,256,1024,4096")
+    args.add_argument("--repeticiones", type=int, default=7)
+    opciones = args.parse_args()
+
+    compilador = os.path.abspath("./a.out")
+    fallas = 0
+    print(f"{'fuente':>10} {'sin cache':>12} {'frio':>12} {'caliente':>12} {'frio/sin':>9} {'sin/caliente':>13}")
+    with tempfile.TemporaryDirectory() as tmp:
+        archivo = os.path.join(tmp, "bench.txt")
+        asm = os.path.join(tmp, "bench.s")
+        cache = os.path.join(tmp, "ast_cache")
+        for kb in (int(x) for x in opciones.kb.split(",")):
+            with open(archivo, "w") as f:
+                f.write(programa(kb))
+
+            sin = [correr(compilador, archivo) for _ in range(opciones.repeticiones)]
+            with open(asm, "rb") as f:
+                esperado = f.read()
+
+            frio = []
+            for _ in range(opciones.repeticiones):
+                shutil.rmtree(cache, ignore_errors=True)
+                frio.append(correr(compilador, archivo, ["--ast-cache=" + cache]))
+            caliente = [correr(compilador, archivo, ["--ast-cache=" + cache])
+                        for _ in range(opciones.repeticiones)]
+            with open(asm, "rb") as f:
+                if f.read() != esperado:
+                    print(f"{kb} KB: el ensamblador en caliente no es el de sin cache")
+                    fallas += 1
+
+            s, fr, c = (statistics.median(t) * 1000 for t in (sin, frio, caliente))
+            print(f"{os.path.getsize(archivo) / 1024:>8.0f}KB {s:>10.1f}ms {fr:>10.1f}ms {c:>10.1f}ms "
+                  f"{fr / s:>8.2f}x {s / c:>12.2f}x")
+    return 1 if fallas else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,276 @@
+#include "canonicalizer.h"
+#include <climits>
+#include <cmath>
+#include <utility>
+
+using namespace std;
+
+static bool literal(Exp* e) {
+    return e->kind == Exp::NUMBER_EXP || e->kind == Exp::BOOL_EXP || e->kind == Exp::FLOAT_EXP;
+}
+
+static long long intValue(Exp* e) {
+    if (NumberExp* n = e->as<NumberExp>()) return n->value;
+    if (BoolExp* b = e->as<BoolExp>()) return b->value ? 1 : 0;
+    return (long long)e->as<FloatExp>()->value; // cvttsd2si
+}
+
+static double floatValue(Exp* e) {
+    if (FloatExp* f = e->as<FloatExp>()) return f->value;
+    return intValue(e);
+}
+
+// Nodo nuevo en lugar de from, con su tipo y su posicion
+static Exp* number(long long value, Exp* from) {
+    Exp* n = new NumberExp((int)value);
+    n->type = from->type;
+    n->pos = from->pos;
+    return n;
+}
+
+// Operador con los operandos intercambiados; false si no conmuta
+static bool mirror(BinaryOp& op) {
+    switch (op) {
+        case PLUS_OP: case MUL_OP: case EQ_OP: case NE_OP: return true;
+        case LT_OP: op = GT_OP; return true;
+        case LE_OP: op = GE_OP; return true;
+        case GT_OP: op = LT_OP; return true;
+        case GE_OP: op = LE_OP; return true;
+        default: return false;
+    }
+}
+
+// + - * dan la vuelta igual que add/imul de 64 bits
+bool Canonicalizer::foldLong(BinaryOp op, long long l, long long r, long long& value) {
+    unsigned long long ul = l, ur = r;
+    switch (op) {
+        case PLUS_OP:  value = (long long)(ul + ur); break;
+        case MINUS_OP: value = (long long)(ul - ur); break;
+        case MUL_OP:   value = (long long)(ul * ur); break;
+        case DIV_OP:
+            // idiv falla en los dos casos
+            if (r == 0 || (l == LLONG_MIN && r == -1)) return false;
+            value = l / r;
+            break;
+        case LT_OP: value = l <  r; break;
+        case LE_OP: value = l <= r; break;
+        case GT_OP: value = l >  r; break;
+        case GE_OP: value = l >= r; break;
+        case EQ_OP: value = l == r; break;
+        case NE_OP: value = l != r; break;
+        default: return false;
+    }
+    return true;
+}
+
+bool Canonicalizer::foldInt(BinaryOp op, long long l, long long r, int& value) {
+    long long v;
+    if (!foldLong(op, l, r, v)) return false;
+    // Fuera de int lo calcula el programa, en 64 bits
+    if (v < INT_MIN || v > INT_MAX) return false;
+    value = (int)v;
+    return true;
+}
+
+// Los hijos ya estan en forma canonica: cada nodo se mira una sola vez
+Exp* Canonicalizer::binary(BinaryExp* e) {
+    if (literal(e->left) && literal(e->right)) {
+        if (e->left->kind != Exp::FLOAT_EXP && e->right->kind != Exp::FLOAT_EXP) {
+            int v;
+            return foldInt(e->op, intValue(e->left), intValue(e->right), v) ? number(v, e) : e;
+        }
+        // En double, como ucomisd/addsd: el mismo valor que calcularia el
+        // programa
+        double l = floatValue(e->left), r = floatValue(e->right), v;
+        switch (e->op) {
+            case PLUS_OP:  v = l + r; break;
+            case MINUS_OP: v = l - r; break;
+            case MUL_OP:   v = l * r; break;
+            case DIV_OP:   v = l / r; break;
+            case LT_OP: return number(l <  r, e);
+            case LE_OP: return number(l <= r, e);
+            case GT_OP: return number(l >  r, e);
+            case GE_OP: return number(l >= r, e);
+            case EQ_OP: return number(l == r, e);
+            case NE_OP: return number(l != r, e);
+            default: return e;
+        }
+        if (!isfinite(v)) return e;
+        Exp* f = new FloatExp(v);
+        f->type = e->type;
+        f->pos = e->pos;
+        return f;
+    }
+
+    if (literal(e->left) && mirror(e->op)) {
+        swap(e->left, e->right);
+    }
+
+    Exp* l = e->left;
+    Exp* r = e->right;
+    bool integer = e->type != FLOAT_VALUE;
+
+    IdExp* lid = l->as<IdExp>();
+    IdExp* rid = r->as<IdExp>();
+    if (e->op == MINUS_OP && integer && lid && rid && lid->sym == rid->sym) {
+        return number(0, e);
+    }
+
+    if (!literal(r)) return e;
+
+    // (x + c1) + c2 -> x + (c1 + c2), igual con *: en enteros de 64 bits
+    // el resultado no cambia aunque algun paso desborde
+    BinaryExp* inner = l->as<BinaryExp>();
+    if (integer && inner && inner->op == e->op && (e->op == PLUS_OP || e->op == MUL_OP) &&
+        inner->type == e->type && inner->right->kind == Exp::NUMBER_EXP && r->kind == Exp::NUMBER_EXP) {
+        int v;
+        if (foldInt(e->op, intValue(inner->right), intValue(r), v)) {
+            inner->right = number(v, inner->right);
+            return binary(inner);
+        }
+    }
+
+    double rv = floatValue(r);
+    bool same = l->type == e->type; // devolver l no cambia el tipo
+    switch (e->op) {
+        case PLUS_OP:
+            // en float x+0 no es x si x es -0
+            if (rv == 0 && integer && same) return l;
+            break;
+        case MINUS_OP:
+            if (rv == 0 && same) return l;
+            break;
+        case MUL_OP:
+            if (rv == 1 && same) return l;
+            if (rv == 0 && integer && lid) return number(0, e);
+            break;
+        case DIV_OP:
+            if (rv == 1 && same) return l;
+            break;
+        default:
+            break;
+    }
+    return e;
+}
+
+Exp* Canonicalizer::exp(Exp* e) {
+    walk([&] { exp(&e); });
+    return e;
+}
+
+void Canonicalizer::exp(Exp** slot) {
+    Exp* e = *slot;
+    switch (e->kind) {
+    case Exp::BINARY_EXP: {
+        BinaryExp* bin = static_cast<BinaryExp*>(e);
+        then([=] { exp(&bin->left); });
+        then([=] { exp(&bin->right); });
+        then([=] { *slot = binary(bin); });
+        break;
+    }
+    case Exp::TERNARY_EXP: {
+        TernaryExp* t = static_cast<TernaryExp*>(e);
+        then([=] { exp(&t->condition); });
+        then([=] { exp(&t->thenExp); });
+        then([=] { exp(&t->elseExp); });
+        then([=] {
+            if (literal(t->condition)) {
+                Exp* taken = intValue(t->condition) != 0 ? t->thenExp : t->elseExp;
+                if (taken->type == t->type) *slot = taken;
+            }
+        });
+        break;
+    }
+    case Exp::FCALL_EXP:
+        for (Exp*& arg : static_cast<FcallExp*>(e)->args) {
+            Exp** a = &arg;
+            then([=] { exp(a); });
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Canonicalizer::stm(Stm* s) {
+    switch (s->kind) {
+    case Stm::VAR_DEC:
+        for (auto& var : static_cast<VarDec*>(s)->vars) {
+            if (var.init_value) {
+                Exp** init = &var.init_value;
+                then([=] { exp(init); });
+            }
+        }
+        break;
+    case Stm::ASSIGN_STM: {
+        AssignStm* a = static_cast<AssignStm*>(s);
+        then([=] { exp(&a->rhs); });
+        break;
+    }
+    case Stm::PRINT_STM:
+        for (Exp*& arg : static_cast<PrintStm*>(s)->args) {
+            Exp** a = &arg;
+            then([=] { exp(a); });
+        }
+        break;
+    case Stm::IF_STM: {
+        IfStm* i = static_cast<IfStm*>(s);
+        then([=] { exp(&i->condition); });
+        if (i->thenbody) then([=] { body(i->thenbody); });
+        if (i->elsebody) then([=] { body(i->elsebody); });
+        break;
+    }
+    case Stm::WHILE_STM: {
+        WhileStm* w = static_cast<WhileStm*>(s);
+        then([=] { exp(&w->condition); });
+        if (w->body) then([=] { body(w->body); });
+        break;
+    }
+    case Stm::FOR_STM: {
+        ForStm* f = static_cast<ForStm*>(s);
+        if (f->init) then([=] { stm(f->init); });
+        if (f->condition) then([=] { exp(&f->condition); });
+        if (f->update) then([=] { stm(f->update); });
+        if (f->body) then([=] { body(f->body); });
+        break;
+    }
+    case Stm::RETURN_STM: {
+        ReturnStm* r = static_cast<ReturnStm*>(s);
+        if (r->expr) then([=] { exp(&r->expr); });
+        break;
+    }
+    case Stm::FCALL_STM: {
+        FcallStm* c = static_cast<FcallStm*>(s);
+        if (c->fcall) then([=] { exp(c->fcall); });
+        break;
+    }
+    }
+}
+
+void Canonicalizer::body(Body* b) {
+    for (VarDec* vd : b->vardecs) {
+        then([=] { stm(vd); });
+    }
+    for (Stm* s : b->stmts) {
+        then([=] { stm(s); });
+    }
+}
+
+void Canonicalizer::run(VarDec* vd) {
+    walk([=] { stm(vd); });
+}
+
+void Canonicalizer::run(FunDec* fd) {
+    if (fd->body) {
+        walk([=] { body(fd->body); });
+    }
+}
+
+void Canonicalizer::run(Program* program) {
+    for (VarDec* vd : program->vardecs) {
+        run(vd);
+    }
+    for (FunDec* fd : program->fundecs) {
+        run(fd);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef CANONICALIZER_H
+#define CANONICALIZER_H
+
+#include "ast.h"
+#include "walker.h"
+
+using namespace std;
+
+// Forma canonica de las expresiones, en una sola pasada de abajo hacia
+// arriba antes del codegen. Necesita los tipos del TypeChecker:
+// - pliega las operaciones entre literales (int y float; comparaciones a 0/1)
+// - x+0, x-0, x*1, x/1 -> x si x ya tiene el tipo del resultado;
+//   x*0 y x-x -> 0 en enteros cuando x es una variable
+// - en + * == != la constante queda a la derecha y se junta con la del
+//   hijo, (x+1)+2 -> x+3; en < <= > >= se da vuelta el operador
+// - un ternario con condicion constante queda en la rama elegida
+// Los nodos nuevos se reservan en Arena::current(). Recorre con la pila del
+// Walker: cada exp(slot) agenda los hijos y despues reemplaza *slot.
+class Canonicalizer : private Walker {
+public:
+    void run(Program* program);
+    void run(FunDec* fd);
+    void run(VarDec* vd);
+    Exp* exp(Exp* e);
+
+    // Aritmetica de enteros como la hace el programa, en 64 bits; false si
+    // no se puede plegar (division por cero o LLONG_MIN / -1)
+    static bool foldLong(BinaryOp op, long long l, long long r, long long& value);
+    // Idem, y ademas false si el resultado no cabe en int
+    static bool foldInt(BinaryOp op, long long l, long long r, int& value);
+
+private:
+    void body(Body* b);
+    void stm(Stm* s);
+    void exp(Exp** slot);
+    Exp* binary(BinaryExp* e);
+};
+
+#endif // CANONICALIZER_H
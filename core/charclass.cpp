@@ -0,0 +1,202 @@
+#include "charclass.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHARCLASS_X86 1
+#endif
+
+using namespace std;
+
+// ------------------ Escalar ------------------
+static const char* skipSpacesScalar(const char* p, const char* end) {
+    while (p < end && hasClass(*p, CC_SPACE)) p++;
+    return p;
+}
+
+static const char* skipIdentScalar(const char* p, const char* end) {
+    while (p < end && hasClass(*p, CC_IDENT)) p++;
+    return p;
+}
+
+static const char* skipDigitsScalar(const char* p, const char* end) {
+    while (p < end && hasClass(*p, CC_DIGIT)) p++;
+    return p;
+}
+
+static const char* skipStringScalar(const char* p, const char* end) {
+    while (p < end && *p != '"') p++;
+    return p;
+}
+
+static const CharKernels scalarKernels = {
+    "scalar", skipSpacesScalar, skipIdentScalar, skipDigitsScalar, skipStringScalar
+};
+
+#ifdef CHARCLASS_X86
+// ------------------ SSE2 (16 bytes) ------------------
+// Cada kernel arma la mascara de bytes que pertenecen a la clase y se
+// detiene en el primer bit apagado; el resto (< 16 bytes) va por escalar.
+// La mayoria de las rachas son cortas (identificadores de pocas letras, un
+// espacio), asi que antes de vectorizar se revisan SHORT_RUN bytes por tabla.
+static const int SHORT_RUN = 8;
+
+static inline bool shortRun(const char*& p, const char* end, unsigned char cls) {
+    for (int i = 0; i < SHORT_RUN; i++, p++) {
+        if (p >= end || !hasClass(*p, cls)) return true;
+    }
+    return false;
+}
+
+static inline bool shortString(const char*& p, const char* end) {
+    for (int i = 0; i < SHORT_RUN; i++, p++) {
+        if (p >= end || *p == '"') return true;
+    }
+    return false;
+}
+
+static inline __m128i inRange16(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+static const char* skipSpacesSSE2(const char* p, const char* end) {
+    if (shortRun(p, end, CC_SPACE)) return p;
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+        unsigned miss = ~(unsigned)_mm_movemask_epi8(m) & 0xFFFFu;
+        if (miss) return p + __builtin_ctz(miss);
+        p += 16;
+    }
+    return skipSpacesScalar(p, end);
+}
+
+static const char* skipIdentSSE2(const char* p, const char* end) {
+    if (shortRun(p, end, CC_IDENT)) return p;
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(inRange16(lower, 'a', 'z'), inRange16(v, '0', '9')),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('.'))));
+        unsigned miss = ~(unsigned)_mm_movemask_epi8(m) & 0xFFFFu;
+        if (miss) return p + __builtin_ctz(miss);
+        p += 16;
+    }
+    return skipIdentScalar(p, end);
+}
+
+static const char* skipDigitsSSE2(const char* p, const char* end) {
+    if (shortRun(p, end, CC_DIGIT)) return p;
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        unsigned miss = ~(unsigned)_mm_movemask_epi8(inRange16(v, '0', '9')) & 0xFFFFu;
+        if (miss) return p + __builtin_ctz(miss);
+        p += 16;
+    }
+    return skipDigitsScalar(p, end);
+}
+
+static const char* skipStringSSE2(const char* p, const char* end) {
+    if (shortString(p, end)) return p;
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)p);
+        unsigned hit = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+        if (hit) return p + __builtin_ctz(hit);
+        p += 16;
+    }
+    return skipStringScalar(p, end);
+}
+
+static const CharKernels sse2Kernels = {
+    "sse2", skipSpacesSSE2, skipIdentSSE2, skipDigitsSSE2, skipStringSSE2
+};
+
+// ------------------ AVX2 (32 bytes) ------------------
+// Compilado con target("avx2") para no exigir -mavx2 en todo el programa;
+// solo se usa si la CPU lo reporta.
+
+__attribute__((target("avx2")))
+static inline __m256i inRange32(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+__attribute__((target("avx2")))
+static const char* skipSpacesAVX2(const char* p, const char* end) {
+    if (shortRun(p, end, CC_SPACE)) return p;
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))));
+        unsigned miss = ~(unsigned)_mm256_movemask_epi8(m);
+        if (miss) return p + __builtin_ctz(miss);
+        p += 32;
+    }
+    return skipSpacesSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* skipIdentAVX2(const char* p, const char* end) {
+    if (shortRun(p, end, CC_IDENT)) return p;
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(inRange32(lower, 'a', 'z'), inRange32(v, '0', '9')),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))));
+        unsigned miss = ~(unsigned)_mm256_movemask_epi8(m);
+        if (miss) return p + __builtin_ctz(miss);
+        p += 32;
+    }
+    return skipIdentSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* skipDigitsAVX2(const char* p, const char* end) {
+    if (shortRun(p, end, CC_DIGIT)) return p;
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        unsigned miss = ~(unsigned)_mm256_movemask_epi8(inRange32(v, '0', '9'));
+        if (miss) return p + __builtin_ctz(miss);
+        p += 32;
+    }
+    return skipDigitsSSE2(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* skipStringAVX2(const char* p, const char* end) {
+    if (shortString(p, end)) return p;
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        unsigned hit = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')));
+        if (hit) return p + __builtin_ctz(hit);
+        p += 32;
+    }
+    return skipStringSSE2(p, end);
+}
+
+static const CharKernels avx2Kernels = {
+    "avx2", skipSpacesAVX2, skipIdentAVX2, skipDigitsAVX2, skipStringAVX2
+};
+#endif
+
+const CharKernels& charKernels(CharKernelVariant variant) {
+#ifdef CHARCLASS_X86
+    if (variant == CharKernelVariant::AVX2 && __builtin_cpu_supports("avx2")) {
+        return avx2Kernels;
+    }
+    if (variant != CharKernelVariant::SCALAR) {
+        return sse2Kernels; // SSE2 es parte de la base x86-64
+    }
+#endif
+    return scalarKernels;
+}
+
+const CharKernels& bestCharKernels() {
+    static const CharKernels& best = charKernels(CharKernelVariant::AVX2);
+    return best;
+}
@@ -0,0 +1,54 @@
+#ifndef CHARCLASS_H
+#define CHARCLASS_H
+
+// Clases de caracteres del scanner (bits combinables)
+enum CharClass : unsigned char {
+    CC_SPACE = 1 << 0,  // ' ', '\n', '\r', '\t'
+    CC_DIGIT = 1 << 1,  // '0'..'9'
+    CC_ALPHA = 1 << 2,  // letras y '_' (inicio de identificador)
+    CC_IDENT = 1 << 3,  // cuerpo de identificador: letras, digitos, '_', '.'
+    CC_OP    = 1 << 4   // operadores y simbolos: + / - * ( ) { } ; , ? : = < >
+};
+
+struct CharClassTable {
+    unsigned char cls[256];
+
+    constexpr CharClassTable() : cls() {
+        cls[(unsigned char)' '] = cls[(unsigned char)'\n'] = CC_SPACE;
+        cls[(unsigned char)'\r'] = cls[(unsigned char)'\t'] = CC_SPACE;
+        for (int c = '0'; c <= '9'; c++) cls[c] = CC_DIGIT | CC_IDENT;
+        for (int c = 'a'; c <= 'z'; c++) cls[c] = CC_ALPHA | CC_IDENT;
+        for (int c = 'A'; c <= 'Z'; c++) cls[c] = CC_ALPHA | CC_IDENT;
+        cls[(unsigned char)'_'] = CC_ALPHA | CC_IDENT;
+        cls[(unsigned char)'.'] = CC_IDENT;
+        const char ops[] = "+/-*(){};,?:=<>";
+        for (int i = 0; ops[i]; i++) cls[(unsigned char)ops[i]] = CC_OP;
+    }
+};
+
+// Tabla de 256 entradas independiente del locale (a diferencia de isalpha)
+inline constexpr CharClassTable charClassTable;
+
+inline bool hasClass(char c, unsigned char mask) {
+    return (charClassTable.cls[(unsigned char)c] & mask) != 0;
+}
+
+// Kernels que avanzan sobre una racha de caracteres de la misma clase y
+// devuelven el primer caracter fuera de ella (o end).
+struct CharKernels {
+    const char* name;
+    const char* (*skipSpaces)(const char* p, const char* end);
+    const char* (*skipIdent)(const char* p, const char* end);
+    const char* (*skipDigits)(const char* p, const char* end);
+    const char* (*skipString)(const char* p, const char* end); // hasta la '"' de cierre
+};
+
+enum class CharKernelVariant { SCALAR, SSE2, AVX2 };
+
+// Variante concreta (cae a una inferior si la CPU no la soporta)
+const CharKernels& charKernels(CharKernelVariant variant);
+
+// Mejor variante disponible, elegida una sola vez en tiempo de ejecucion
+const CharKernels& bestCharKernels();
+
+#endif // CHARCLASS_H
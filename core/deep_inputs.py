@@ -0,0 +1,85 @@
+import os
+import subprocess
+import sys
+import tempfile
+
+# Programas con 100000 niveles de anidamiento: ninguna pasada del compilador
+# (parser, FlatAst, checker, codegen) puede recursar por nivel. Cada uno se
+# compila con ./a.out por el camino normal, con --flat-ast y dos veces con
+# --ast-cache (la primera arma el snapshot, la segunda lo reconstruye); el
+# ensamblador tiene que salir igual en todos los casos.
+PROFUNDIDAD = 100000
+
+
+def anidado_if(n):
+    partes = ["int main() {\n    int x = 0;\n"]
+    partes.append("if (x < %d) {\n" % (n + 5) * n)
+    partes.append("x = x + 1;\n")
+    partes.append("}\n" * n)
+    partes.append('printf("%d\\n", x);\nreturn 0;\n}\n')
+    return "".join(partes)
+
+
+# if / while / for alternados, con una local por nivel
+def anidado_mixto(n):
+    partes = ["int main() {\n    int x = 0;\n"]
+    for i in range(n):
+        if i % 3 == 0:
+            partes.append("if (x >= 0) {\nint a%d = x + 1;\n" % i)
+        elif i % 3 == 1:
+            partes.append("while (x < 0) {\nint b%d = x;\nx = b%d + 1;\n" % (i, i))
+        else:
+            partes.append("for (x = x; x < 1000000; x = x + 1) {\nint c%d = x * 2;\nx = c%d;\n" % (i, i))
+    partes.append("x = x + 1;\n")
+    for i in reversed(range(n)):
+        if i % 3 == 0:
+            partes.append("x = x + a%d - x;\n}\n" % i)
+        elif i % 3 == 1:
+            partes.append("}\n")
+        else:
+            partes.append("x = 1000000;\n}\n")
+    partes.append('printf("%d\\n", x);\nreturn 0;\n}\n')
+    return "".join(partes)
+
+
+def expresion(texto):
+    return "int main() {\n    int x = 1;\n    int y = " + texto + ";\n    printf(\"%d\\n\", y);\n    return 0;\n}\n"
+
+
+programas = {
+    "if": anidado_if(PROFUNDIDAD),
+    "mixto": anidado_mixto(PROFUNDIDAD),
+    "suma": expresion("x" + " + x" * PROFUNDIDAD),
+    "parentesis": expresion("(" * PROFUNDIDAD + "x" + " + 1)" * PROFUNDIDAD),
+    "ternario": expresion("x > 0 ? " * PROFUNDIDAD + "7" + " : 0" * PROFUNDIDAD),
+}
+
+compilador = os.path.abspath("./a.out")
+fallas = 0
+
+with tempfile.TemporaryDirectory() as tmp:
+    cache = os.path.join(tmp, "ast_cache")
+    for nombre, fuente in programas.items():
+        archivo = os.path.join(tmp, f"profundo_{nombre}.txt")
+        asm = os.path.join(tmp, f"profundo_{nombre}.s")
+        with open(archivo, "w") as f:
+            f.write(fuente)
+
+        salidas = []
+        for modo in [[], ["--flat-ast"], ["--ast-cache=" + cache], ["--ast-cache=" + cache]]:
+            result = subprocess.run([compilador] + modo + [archivo], capture_output=True, text=True)
+            etiqueta = " ".join(modo) or "normal"
+            if result.returncode != 0:
+                print(f"Profundo {nombre} ({etiqueta}): rc={result.returncode}")
+                fallas += 1
+                continue
+            with open(asm) as f:
+                salidas.append(f.read())
+
+        if salidas and any(s != salidas[0] for s in salidas):
+            print(f"Profundo {nombre}: el ensamblador cambia segun el modo")
+            fallas += 1
+        elif len(salidas) == 4:
+            print(f"Profundo {nombre}: ok")
+
+sys.exit(1 if fallas else 0)
@@ -1,25 +1,42 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
-#include <unordered_map>
 #include <vector>
-#include <string>
-#include <iostream>
+#include <cstdint>
+#include "symbols.h"
 
 using namespace std;
 
+const uint32_t NO_BINDING = UINT32_MAX;
+
 template <typename T>
 class Environment {
+    // Las variables se identifican por su SymbolId.
+    // Todas las ligaduras viven en un solo arreglo, en orden de declaracion;
+    // head[sym] apunta a la mas interna de sym y cada ligadura guarda la que
+    // tapa. Un nivel es solo la marca de donde empieza, asi que entrar y
+    // salir de un bloque no reserva memoria.
 private:
-    vector<unordered_map<string, T>> ribs;
+    struct Binding {
+        SymbolId sym;
+        uint32_t shadowed; // ligadura anterior del mismo simbolo
+        T value;
+    };
+
+    vector<Binding> bindings;
+    vector<uint32_t> head;  // por SymbolId
+    vector<uint32_t> marks; // bindings.size() al abrir cada nivel
 
-    int search_rib(const string& var) const {
-        for (int i = ribs.size() - 1; i >= 0; i--) {
-            if (ribs[i].count(var)) {
-                return i;
-            }
+    uint32_t find_binding(SymbolId var) const {
+        return var < head.size() ? head[var] : NO_BINDING;
+    }
+
+    void pop_to(size_t size) {
+        while (bindings.size() > size) {
+            const Binding& b = bindings.back();
+            head[b.sym] = b.shadowed;
+            bindings.pop_back();
         }
-        return -1;
     }
 
 public:
@@ -28,50 +45,66 @@ public:
     }
 
     void clear() {
-        ribs.clear();
+        pop_to(0);
+        marks.clear();
     }
 
     void add_level() {
-        ribs.push_back(unordered_map<string, T>());
+        marks.push_back(bindings.size());
     }
 
-    void add_var(const string& var, const T& value) {
-        if (!ribs.empty()) {
-            ribs.back()[var] = value;
+    void add_var(SymbolId var, const T& value) {
+        if (marks.empty()) {
+            return;
+        }
+        uint32_t i = find_binding(var);
+        if (i != NO_BINDING && i >= marks.back()) {
+            bindings[i].value = value; // redeclarada en el mismo nivel
+            return;
         }
+        if (var >= head.size()) {
+            head.resize(var + 1, NO_BINDING);
+        }
+        bindings.push_back({var, i, value});
+        head[var] = bindings.size() - 1;
     }
 
-    void add_var(const string& var) {
-        if (!ribs.empty()) {
-            ribs.back()[var] = T();
-        }
+    void add_var(SymbolId var) {
+        add_var(var, T());
     }
 
     bool remove_level() {
-        if (!ribs.empty()) {
-            ribs.pop_back();
+        if (!marks.empty()) {
+            pop_to(marks.back());
+            marks.pop_back();
             return true;
         }
         return false;
     }
 
-    bool update(const string& x, const T& v) {
-        int rib = search_rib(x);
-        if (rib >= 0) {
-            ribs[rib][x] = v;
+    bool update(SymbolId x, const T& v) {
+        uint32_t i = find_binding(x);
+        if (i != NO_BINDING) {
+            bindings[i].value = v;
             return true;
         }
         return false;
     }
 
-    bool check(const string& x) const {
-        return search_rib(x) >= 0;
+    bool check(SymbolId x) const {
+        return find_binding(x) != NO_BINDING;
+    }
+
+    // nullptr si no esta; evita el check + lookup
+    const T* find(SymbolId x) const {
+        uint32_t i = find_binding(x);
+        return i != NO_BINDING ? &bindings[i].value : nullptr;
     }
 
-    T lookup(const string& x) const {
-        int rib = search_rib(x);
-        if (rib >= 0) {
-            return ribs[rib].at(x);
+    T lookup(SymbolId x) const {
+        uint32_t i = find_binding(x);
+        if (i != NO_BINDING) {
+            return bindings[i].value;
         }
         return T();
     }
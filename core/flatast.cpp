@@ -0,0 +1,924 @@
+#include "flatast.h"
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+using namespace std;
+
+// ------------------ Aplanado ------------------
+
+// Cada nombre distinto se guarda una vez; s apunta al AST que se esta
+// aplanando, que sigue vivo hasta el final de build()
+uint32_t FlatAst::addName(string_view s) {
+    auto found = nameIds.find(s);
+    if (found != nameIds.end()) {
+        return found->second;
+    }
+    nameStart.push_back(text.size());
+    nameLen.push_back(s.size());
+    text.append(s.begin(), s.end());
+    nameIds.emplace(s, nameStart.size() - 1);
+    return nameStart.size() - 1;
+}
+
+// Con el SymbolId del parser no hace falta hashear el texto
+uint32_t FlatAst::addName(string_view s, SymbolId sym) {
+    if (sym == NO_SYMBOL) {
+        return addName(s);
+    }
+    if (sym >= nameBySymbol.size()) {
+        nameBySymbol.resize(sym + 1, NO_NODE);
+    }
+    if (nameBySymbol[sym] == NO_NODE) {
+        nameBySymbol[sym] = addName(s);
+    }
+    return nameBySymbol[sym];
+}
+
+FlatAst::Range FlatAst::addRefs(const vector<NodeRef>& list) {
+    Range r;
+    r.first = refs.size();
+    r.count = list.size();
+    refs.append(list.begin(), list.end());
+    return r;
+}
+
+NodeRef FlatAst::addType(TypeDecl* type) {
+    if (!type) return NO_NODE;
+    typeKind.push_back(type->kind);
+    typeName.push_back(type->name.empty() ? NO_NODE : addName(type->name));
+    return typeKind.size() - 1;
+}
+
+// Aplanado con pila de trabajo explicita, como parseBody: cada nodo sale
+// dos veces. La primera apila sus hijos y, debajo, su segunda vuelta
+// (done), que los saca de 'built' ya aplanados y agrega el nodo. Los
+// indices quedan en postorden y la pila nativa no crece con el anidamiento.
+class FlatAst::Builder {
+public:
+    explicit Builder(FlatAst& ast) : ast(ast) {}
+
+    NodeRef stm(Stm* s) {
+        schedule(s);
+        return run();
+    }
+    NodeRef body(Body* b) {
+        schedule(b);
+        return run();
+    }
+
+private:
+    struct Task {
+        enum What : uint8_t { EXP, STM, BODY } what;
+        bool done;
+        union {
+            Exp* exp;
+            Stm* stm;
+            Body* body;
+        };
+    };
+
+    FlatAst& ast;
+    vector<Task> work;     // por hacer, el proximo al final
+    vector<NodeRef> built; // nodos ya aplanados que esperan a su padre
+
+    void schedule(Exp* e)  { Task t; t.what = Task::EXP; t.done = false; t.exp = e; work.push_back(t); }
+    void schedule(Stm* s)  { Task t; t.what = Task::STM; t.done = false; t.stm = s; work.push_back(t); }
+    void schedule(Body* b) { Task t; t.what = Task::BODY; t.done = false; t.body = b; work.push_back(t); }
+    template <typename T>
+    void finishLater(T* node) {
+        schedule(node);
+        work.back().done = true;
+    }
+
+    NodeRef run();
+    NodeRef pop() {
+        NodeRef r = built.back();
+        built.pop_back();
+        return r;
+    }
+    // Los ultimos n, en orden
+    vector<NodeRef> take(size_t n) {
+        vector<NodeRef> list(built.end() - n, built.end());
+        built.resize(built.size() - n);
+        return list;
+    }
+
+    void visitExp(Exp* exp);
+    void visitStm(Stm* stm);
+    void visitBody(Body* body);
+    void finishExp(Exp* exp);
+    void finishStm(Stm* stm);
+    void finishBody(Body* body);
+    void pushExp(uint8_t kind, Exp* exp, uint32_t a, uint32_t b = 0, uint32_t c = 0);
+    void pushStm(uint8_t kind, Stm* stm, uint32_t a, uint32_t b = 0, uint32_t c = 0, uint32_t d = 0);
+};
+
+NodeRef FlatAst::Builder::run() {
+    while (!work.empty()) {
+        Task t = work.back();
+        work.pop_back();
+        switch (t.what) {
+            case Task::EXP:  t.done ? finishExp(t.exp) : visitExp(t.exp); break;
+            case Task::STM:  t.done ? finishStm(t.stm) : visitStm(t.stm); break;
+            case Task::BODY: t.done ? finishBody(t.body) : visitBody(t.body); break;
+        }
+    }
+    return pop();
+}
+
+void FlatAst::Builder::pushExp(uint8_t kind, Exp* exp, uint32_t a, uint32_t b, uint32_t c) {
+    ast.expKind.push_back(kind);
+    ast.expPos.push_back(exp->pos);
+    ast.expA.push_back(a);
+    ast.expB.push_back(b);
+    ast.expC.push_back(c);
+    built.push_back(ast.expKind.size() - 1);
+}
+
+void FlatAst::Builder::pushStm(uint8_t kind, Stm* stm, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    ast.stmKind.push_back(kind);
+    ast.stmPos.push_back(stm->pos);
+    ast.stmA.push_back(a);
+    ast.stmB.push_back(b);
+    ast.stmC.push_back(c);
+    ast.stmD.push_back(d);
+    built.push_back(ast.stmKind.size() - 1);
+}
+
+// Las hojas se agregan enseguida; el resto apila sus hijos en orden inverso
+// para que salga primero el primero
+void FlatAst::Builder::visitExp(Exp* exp) {
+    if (!exp) {
+        built.push_back(NO_NODE);
+        return;
+    }
+
+    switch (exp->kind) {
+    case Exp::BINARY_EXP: {
+        BinaryExp* bin = static_cast<BinaryExp*>(exp);
+        finishLater(exp);
+        schedule(bin->right);
+        schedule(bin->left);
+        break;
+    }
+    case Exp::NUMBER_EXP:
+        pushExp(NUMBER_EXP, exp, (uint32_t)static_cast<NumberExp*>(exp)->value);
+        break;
+    case Exp::FLOAT_EXP: {
+        uint64_t bits;
+        memcpy(&bits, &static_cast<FloatExp*>(exp)->value, sizeof(bits));
+        pushExp(FLOAT_EXP, exp, (uint32_t)bits, (uint32_t)(bits >> 32));
+        break;
+    }
+    case Exp::ID_EXP: {
+        IdExp* id = static_cast<IdExp*>(exp);
+        pushExp(ID_EXP, exp, ast.addName(id->value, id->sym));
+        break;
+    }
+    case Exp::BOOL_EXP:
+        pushExp(BOOL_EXP, exp, static_cast<BoolExp*>(exp)->value ? 1 : 0);
+        break;
+    case Exp::STRING_EXP: {
+        StringExp* str = static_cast<StringExp*>(exp);
+        pushExp(STRING_EXP, exp, ast.addName(str->value, str->sym));
+        break;
+    }
+    case Exp::FCALL_EXP: {
+        FcallExp* call = static_cast<FcallExp*>(exp);
+        finishLater(exp);
+        for (auto it = call->args.rbegin(); it != call->args.rend(); ++it) {
+            schedule(*it);
+        }
+        break;
+    }
+    case Exp::TERNARY_EXP: {
+        TernaryExp* tern = static_cast<TernaryExp*>(exp);
+        finishLater(exp);
+        schedule(tern->elseExp);
+        schedule(tern->thenExp);
+        schedule(tern->condition);
+        break;
+    }
+    default:
+        built.push_back(NO_NODE);
+    }
+}
+
+void FlatAst::Builder::finishExp(Exp* exp) {
+    switch (exp->kind) {
+    case Exp::BINARY_EXP: {
+        NodeRef b = pop(), a = pop();
+        pushExp(BINARY_EXP, exp, a, b, static_cast<BinaryExp*>(exp)->op);
+        break;
+    }
+    case Exp::FCALL_EXP: {
+        FcallExp* call = static_cast<FcallExp*>(exp);
+        Range r = ast.addRefs(take(call->args.size()));
+        pushExp(FCALL_EXP, exp, ast.addName(call->fname, call->sym), r.first, r.count);
+        break;
+    }
+    case Exp::TERNARY_EXP: {
+        NodeRef c = pop(), b = pop(), a = pop();
+        pushExp(TERNARY_EXP, exp, a, b, c);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void FlatAst::Builder::visitStm(Stm* stm) {
+    if (!stm) {
+        built.push_back(NO_NODE);
+        return;
+    }
+
+    switch (stm->kind) {
+    case Stm::VAR_DEC: {
+        VarDec* vd = static_cast<VarDec*>(stm);
+        finishLater(stm);
+        for (auto it = vd->vars.rbegin(); it != vd->vars.rend(); ++it) {
+            schedule(it->init_value);
+        }
+        break;
+    }
+    case Stm::ASSIGN_STM:
+        finishLater(stm);
+        schedule(static_cast<AssignStm*>(stm)->rhs);
+        break;
+    case Stm::PRINT_STM: {
+        PrintStm* pr = static_cast<PrintStm*>(stm);
+        finishLater(stm);
+        for (auto it = pr->args.rbegin(); it != pr->args.rend(); ++it) {
+            schedule(*it);
+        }
+        break;
+    }
+    case Stm::IF_STM: {
+        IfStm* is = static_cast<IfStm*>(stm);
+        finishLater(stm);
+        schedule(is->elsebody);
+        schedule(is->thenbody);
+        schedule(is->condition);
+        break;
+    }
+    case Stm::WHILE_STM: {
+        WhileStm* ws = static_cast<WhileStm*>(stm);
+        finishLater(stm);
+        schedule(ws->body);
+        schedule(ws->condition);
+        break;
+    }
+    case Stm::FOR_STM: {
+        ForStm* fs = static_cast<ForStm*>(stm);
+        finishLater(stm);
+        schedule(fs->body);
+        schedule(fs->update);
+        schedule(fs->condition);
+        schedule(fs->init);
+        break;
+    }
+    case Stm::RETURN_STM:
+        finishLater(stm);
+        schedule(static_cast<ReturnStm*>(stm)->expr);
+        break;
+    case Stm::FCALL_STM:
+        finishLater(stm);
+        schedule(static_cast<FcallStm*>(stm)->fcall);
+        break;
+    default:
+        built.push_back(NO_NODE);
+    }
+}
+
+void FlatAst::Builder::finishStm(Stm* stm) {
+    switch (stm->kind) {
+    case Stm::VAR_DEC: {
+        VarDec* vd = static_cast<VarDec*>(stm);
+        vector<NodeRef> inits = take(vd->vars.size());
+        uint32_t b = ast.varName.size();
+        for (auto& var : vd->vars) {
+            ast.varName.push_back(ast.addName(var.name, var.sym));
+        }
+        ast.varInit.append(inits.begin(), inits.end());
+        pushStm(VAR_DEC, stm, ast.addType(vd->type), b, inits.size());
+        break;
+    }
+    case Stm::ASSIGN_STM: {
+        AssignStm* as = static_cast<AssignStm*>(stm);
+        pushStm(ASSIGN_STM, stm, ast.addName(as->id, as->sym), pop());
+        break;
+    }
+    case Stm::PRINT_STM: {
+        Range r = ast.addRefs(take(static_cast<PrintStm*>(stm)->args.size()));
+        pushStm(PRINT_STM, stm, 0, r.first, r.count);
+        break;
+    }
+    case Stm::IF_STM: {
+        NodeRef c = pop(), b = pop(), a = pop();
+        pushStm(IF_STM, stm, a, b, c);
+        break;
+    }
+    case Stm::WHILE_STM: {
+        NodeRef b = pop(), a = pop();
+        pushStm(WHILE_STM, stm, a, b);
+        break;
+    }
+    case Stm::FOR_STM: {
+        NodeRef d = pop(), c = pop(), b = pop(), a = pop();
+        pushStm(FOR_STM, stm, a, b, c, d);
+        break;
+    }
+    case Stm::RETURN_STM:
+        pushStm(RETURN_STM, stm, pop());
+        break;
+    case Stm::FCALL_STM:
+        pushStm(FCALL_STM, stm, pop());
+        break;
+    default:
+        break;
+    }
+}
+
+void FlatAst::Builder::visitBody(Body* body) {
+    if (!body) {
+        built.push_back(NO_NODE);
+        return;
+    }
+    finishLater(body);
+    for (auto it = body->stmts.rbegin(); it != body->stmts.rend(); ++it) {
+        schedule(*it);
+    }
+    for (auto it = body->vardecs.rbegin(); it != body->vardecs.rend(); ++it) {
+        schedule(*it);
+    }
+}
+
+void FlatAst::Builder::finishBody(Body* body) {
+    vector<NodeRef> stmts = take(body->stmts.size());
+    vector<NodeRef> vardecs = take(body->vardecs.size());
+    ast.bodyPos.push_back(body->pos);
+    ast.bodyVarDecs.push_back(ast.addRefs(vardecs));
+    ast.bodyStmts.push_back(ast.addRefs(stmts));
+    built.push_back(ast.bodyPos.size() - 1);
+}
+
+void FlatAst::build(Program* prog) {
+    Builder builder(*this);
+    vector<NodeRef> list;
+    for (VarDec* vd : prog->vardecs) {
+        list.push_back(builder.stm(vd));
+    }
+    globals = addRefs(list);
+
+    for (StructDec* sd : prog->structdecs) {
+        if (!sd) continue;
+        list.clear();
+        for (VarDec* field : sd->fields) {
+            list.push_back(builder.stm(field));
+        }
+        structPos.push_back(sd->pos);
+        structName.push_back(addName(sd->name));
+        structFields.push_back(addRefs(list));
+    }
+
+    for (FunDec* fd : prog->fundecs) {
+        Range params;
+        params.first = paramType.size();
+        params.count = fd->pnames.size();
+        for (size_t i = 0; i < fd->pnames.size(); i++) {
+            paramType.push_back(i < fd->ptypes.size() ? addType(fd->ptypes[i]) : NO_NODE);
+            paramName.push_back(addName(fd->pnames[i], i < fd->psyms.size() ? fd->psyms[i] : NO_SYMBOL));
+        }
+        funPos.push_back(fd->pos);
+        funRType.push_back(addType(fd->rtype));
+        funName.push_back(addName(fd->name, fd->sym));
+        funParams.push_back(params);
+        funBody.push_back(builder.body(fd->body));
+    }
+    nameIds = unordered_map<string_view, uint32_t>();
+    nameBySymbol = vector<uint32_t>();
+}
+
+// ------------------ Reconstruccion ------------------
+
+TypeDecl* FlatAst::raiseType(NodeRef t) const {
+    if (t == NO_NODE) return nullptr;
+    string_view n = typeName[t] == NO_NODE ? string_view() : name(typeName[t]);
+    return new TypeDecl((TypeDecl::TypeKind)typeKind[t], n);
+}
+
+// Igual que Builder, sobre indices: los nodos reconstruidos esperan a su
+// padre en una pila por clase de nodo.
+class FlatAst::Raiser {
+public:
+    explicit Raiser(const FlatAst& ast) : ast(ast) {}
+
+    Stm* stm(NodeRef s) {
+        schedule(Task::STM, s);
+        run();
+        return pop(stms);
+    }
+    Body* body(NodeRef b) {
+        schedule(Task::BODY, b);
+        run();
+        return pop(bodies);
+    }
+
+private:
+    struct Task {
+        enum What : uint8_t { EXP, STM, BODY } what;
+        bool done;
+        NodeRef ref;
+    };
+
+    const FlatAst& ast;
+    vector<Task> work;
+    vector<Exp*> exps;
+    vector<Stm*> stms;
+    vector<Body*> bodies;
+
+    void schedule(Task::What what, NodeRef ref, bool done = false) {
+        work.push_back(Task{what, done, ref});
+    }
+    // Los hijos de una lista, en orden inverso
+    void scheduleAll(Task::What what, const NodeRef* first, uint32_t count) {
+        for (uint32_t i = count; i > 0; i--) {
+            schedule(what, first[i - 1]);
+        }
+    }
+
+    template <typename T>
+    static T* pop(vector<T*>& from) {
+        T* node = from.back();
+        from.pop_back();
+        return node;
+    }
+    // Pasa los ultimos n de from a list, en orden
+    template <typename List>
+    static void moveLast(vector<Exp*>& from, size_t n, List& list) {
+        for (size_t i = from.size() - n; i < from.size(); i++) {
+            list.push_back(from[i]);
+        }
+        from.resize(from.size() - n);
+    }
+
+    void doneExp(Exp* exp, NodeRef e) {
+        exp->pos = ast.expPos[e];
+        exps.push_back(exp);
+    }
+    void doneStm(Stm* stm, NodeRef s) {
+        stm->pos = ast.stmPos[s];
+        stms.push_back(stm);
+    }
+
+    void run();
+    void visitExp(NodeRef e);
+    void visitStm(NodeRef s);
+    void visitBody(NodeRef b);
+    void finishExp(NodeRef e);
+    void finishStm(NodeRef s);
+    void finishBody(NodeRef b);
+};
+
+void FlatAst::Raiser::run() {
+    while (!work.empty()) {
+        Task t = work.back();
+        work.pop_back();
+        switch (t.what) {
+            case Task::EXP:  t.done ? finishExp(t.ref) : visitExp(t.ref); break;
+            case Task::STM:  t.done ? finishStm(t.ref) : visitStm(t.ref); break;
+            case Task::BODY: t.done ? finishBody(t.ref) : visitBody(t.ref); break;
+        }
+    }
+}
+
+void FlatAst::Raiser::visitExp(NodeRef e) {
+    if (e == NO_NODE) {
+        exps.push_back(nullptr);
+        return;
+    }
+    uint32_t a = ast.expA[e], b = ast.expB[e], c = ast.expC[e];
+
+    switch (ast.expKind[e]) {
+        case BINARY_EXP:
+            schedule(Task::EXP, e, true);
+            schedule(Task::EXP, b);
+            schedule(Task::EXP, a);
+            break;
+        case NUMBER_EXP:
+            doneExp(new NumberExp((int)a), e);
+            break;
+        case FLOAT_EXP: {
+            uint64_t bits = (uint64_t)b << 32 | a;
+            double v;
+            memcpy(&v, &bits, sizeof(v));
+            doneExp(new FloatExp(v), e);
+            break;
+        }
+        case ID_EXP:
+            doneExp(new IdExp(ast.name(a), ast.symbol(a)), e);
+            break;
+        case BOOL_EXP:
+            doneExp(new BoolExp(a != 0), e);
+            break;
+        case STRING_EXP:
+            doneExp(new StringExp(ast.name(a), ast.symbol(a)), e);
+            break;
+        case FCALL_EXP:
+            schedule(Task::EXP, e, true);
+            scheduleAll(Task::EXP, ast.refs.data() + b, c);
+            break;
+        case TERNARY_EXP:
+            schedule(Task::EXP, e, true);
+            schedule(Task::EXP, c);
+            schedule(Task::EXP, b);
+            schedule(Task::EXP, a);
+            break;
+    }
+}
+
+void FlatAst::Raiser::finishExp(NodeRef e) {
+    uint32_t a = ast.expA[e], c = ast.expC[e];
+
+    switch (ast.expKind[e]) {
+        case BINARY_EXP: {
+            Exp* right = pop(exps);
+            Exp* left = pop(exps);
+            doneExp(new BinaryExp(left, right, (BinaryOp)c), e);
+            break;
+        }
+        case FCALL_EXP: {
+            FcallExp* call = new FcallExp(ast.name(a), ast.symbol(a));
+            moveLast(exps, c, call->args);
+            doneExp(call, e);
+            break;
+        }
+        case TERNARY_EXP: {
+            Exp* elseExp = pop(exps);
+            Exp* thenExp = pop(exps);
+            Exp* condition = pop(exps);
+            doneExp(new TernaryExp(condition, thenExp, elseExp), e);
+            break;
+        }
+    }
+}
+
+// Todas las sentencias tienen hijos
+void FlatAst::Raiser::visitStm(NodeRef s) {
+    if (s == NO_NODE) {
+        stms.push_back(nullptr);
+        return;
+    }
+    uint32_t a = ast.stmA[s], b = ast.stmB[s], c = ast.stmC[s], d = ast.stmD[s];
+
+    schedule(Task::STM, s, true);
+    switch (ast.stmKind[s]) {
+        case VAR_DEC:
+            scheduleAll(Task::EXP, ast.varInit.data() + b, c);
+            break;
+        case ASSIGN_STM:
+            schedule(Task::EXP, b);
+            break;
+        case PRINT_STM:
+            scheduleAll(Task::EXP, ast.refs.data() + b, c);
+            break;
+        case IF_STM:
+            schedule(Task::BODY, c);
+            schedule(Task::BODY, b);
+            schedule(Task::EXP, a);
+            break;
+        case WHILE_STM:
+            schedule(Task::BODY, b);
+            schedule(Task::EXP, a);
+            break;
+        case FOR_STM:
+            schedule(Task::BODY, d);
+            schedule(Task::STM, c);
+            schedule(Task::EXP, b);
+            schedule(Task::STM, a);
+            break;
+        case RETURN_STM:
+        case FCALL_STM:
+            schedule(Task::EXP, a);
+            break;
+    }
+}
+
+void FlatAst::Raiser::finishStm(NodeRef s) {
+    uint32_t a = ast.stmA[s], b = ast.stmB[s], c = ast.stmC[s];
+
+    switch (ast.stmKind[s]) {
+        case VAR_DEC: {
+            VarDec* vd = new VarDec(ast.raiseType(a));
+            size_t first = exps.size() - c;
+            for (uint32_t i = 0; i < c; i++) {
+                uint32_t n = ast.varName[b + i];
+                vd->addVar(ast.name(n), ast.symbol(n), exps[first + i]);
+            }
+            exps.resize(first);
+            doneStm(vd, s);
+            break;
+        }
+        case ASSIGN_STM:
+            doneStm(new AssignStm(ast.name(a), ast.symbol(a), pop(exps)), s);
+            break;
+        case PRINT_STM: {
+            PrintStm* pr = new PrintStm();
+            moveLast(exps, c, pr->args);
+            doneStm(pr, s);
+            break;
+        }
+        case IF_STM: {
+            Body* elsebody = pop(bodies);
+            Body* thenbody = pop(bodies);
+            doneStm(new IfStm(pop(exps), thenbody, elsebody), s);
+            break;
+        }
+        case WHILE_STM: {
+            Body* body = pop(bodies);
+            doneStm(new WhileStm(pop(exps), body), s);
+            break;
+        }
+        case FOR_STM: {
+            Body* body = pop(bodies);
+            AssignStm* update = static_cast<AssignStm*>(pop(stms));
+            Stm* init = pop(stms);
+            doneStm(new ForStm(init, pop(exps), update, body), s);
+            break;
+        }
+        case RETURN_STM:
+            doneStm(new ReturnStm(pop(exps)), s);
+            break;
+        case FCALL_STM:
+            doneStm(new FcallStm(static_cast<FcallExp*>(pop(exps))), s);
+            break;
+    }
+}
+
+void FlatAst::Raiser::visitBody(NodeRef b) {
+    if (b == NO_NODE) {
+        bodies.push_back(nullptr);
+        return;
+    }
+    Range vardecs = ast.bodyVarDecs[b], stmts = ast.bodyStmts[b];
+    schedule(Task::BODY, b, true);
+    scheduleAll(Task::STM, ast.refs.data() + stmts.first, stmts.count);
+    scheduleAll(Task::STM, ast.refs.data() + vardecs.first, vardecs.count);
+}
+
+// Las declaraciones quedaron debajo de las sentencias
+void FlatAst::Raiser::finishBody(NodeRef b) {
+    Range vardecs = ast.bodyVarDecs[b], stmts = ast.bodyStmts[b];
+    Body* body = new Body();
+    body->pos = ast.bodyPos[b];
+    size_t first = stms.size() - vardecs.count - stmts.count;
+    for (size_t i = first; i < first + vardecs.count; i++) {
+        body->vardecs.push_back(static_cast<VarDec*>(stms[i]));
+    }
+    for (size_t i = first + vardecs.count; i < stms.size(); i++) {
+        body->stmts.push_back(stms[i]);
+    }
+    stms.resize(first);
+    bodies.push_back(body);
+}
+
+Program* FlatAst::raise() const {
+    Raiser raiser(*this);
+    Program* prog = new Program();
+    for (NodeRef vd : children(globals)) {
+        prog->vardecs.push_back(static_cast<VarDec*>(raiser.stm(vd)));
+    }
+    for (size_t i = 0; i < structName.size(); i++) {
+        StructDec* sd = new StructDec(name(structName[i]));
+        sd->pos = structPos[i];
+        for (NodeRef field : children(structFields[i])) {
+            sd->fields.push_back(static_cast<VarDec*>(raiser.stm(field)));
+        }
+        prog->structdecs.push_back(sd);
+    }
+    for (size_t f = 0; f < funName.size(); f++) {
+        ArenaVector<TypeDecl*> ptypes;
+        ArenaVector<string_view> pnames;
+        ArenaVector<SymbolId> psyms;
+        Range params = funParams[f];
+        for (uint32_t i = params.first; i < params.first + params.count; i++) {
+            ptypes.push_back(raiseType(paramType[i]));
+            pnames.push_back(name(paramName[i]));
+            psyms.push_back(symbol(paramName[i]));
+        }
+        FunDec* fd = new FunDec(raiseType(funRType[f]), name(funName[f]), symbol(funName[f]),
+                                move(ptypes), move(pnames), move(psyms), raiser.body(funBody[f]));
+        fd->pos = funPos[f];
+        prog->fundecs.push_back(fd);
+    }
+    return prog;
+}
+
+// ------------------ Snapshot ------------------
+
+template <typename Self, typename F>
+void FlatAst::forEachColumn(Self& self, F f) {
+    f(self.expKind); f(self.expPos); f(self.expA); f(self.expB); f(self.expC);
+    f(self.stmKind); f(self.stmPos); f(self.stmA); f(self.stmB); f(self.stmC); f(self.stmD);
+    f(self.varName); f(self.varInit);
+    f(self.typeKind); f(self.typeName);
+    f(self.bodyPos); f(self.bodyVarDecs); f(self.bodyStmts);
+    f(self.structPos); f(self.structName); f(self.structFields);
+    f(self.funPos); f(self.funName); f(self.funRType); f(self.funBody); f(self.funParams);
+    f(self.paramType); f(self.paramName);
+    f(self.refs);
+    f(self.text); f(self.nameStart); f(self.nameLen);
+}
+
+static const char PADDING[8] = {};
+
+// Por columna: cantidad (uint64) y los elementos, rellenado a 8 bytes
+void FlatAst::serialize(ostream& out) const {
+    size_t written = 0;
+    auto write = [&](const void* data, size_t n) {
+        out.write((const char*)data, n);
+        written += n;
+    };
+    write(&globals, sizeof(globals));
+    forEachColumn(*this, [&](const auto& col) {
+        uint64_t count = col.size();
+        write(&count, sizeof(count));
+        write(col.data(), count * sizeof(col[0]));
+        write(PADDING, (8 - written % 8) % 8);
+    });
+}
+
+bool FlatAst::attach(const char* data, size_t size) {
+    size_t at = 0;
+    if (size < sizeof(globals)) return false;
+    memcpy(&globals, data, sizeof(globals));
+    at += sizeof(globals);
+    bool ok = true;
+    forEachColumn(*this, [&](auto& col) {
+        typedef typename remove_reference<decltype(col)>::type::value_type T;
+        uint64_t count;
+        if (!ok || size - at < sizeof(count)) {
+            ok = false;
+            return;
+        }
+        memcpy(&count, data + at, sizeof(count));
+        at += sizeof(count);
+        if (count > (size - at) / sizeof(T)) {
+            ok = false;
+            return;
+        }
+        col.attach((const T*)(data + at), count);
+        at += (count * sizeof(T) + 7) / 8 * 8;
+        at = min(at, size);
+    });
+    return ok && valid();
+}
+
+// Un snapshot truncado o corrupto no puede hacer que raise() lea fuera de
+// una columna ni que entre en un ciclo: cada indice tiene que caer en su
+// columna y, como build() los deja en postorden, cada hijo tiene que ser
+// anterior a su padre. Un cuerpo cuenta como hijo de su sentencia a traves
+// de sus sentencias (stmEnd). NO_NODE solo se acepta donde el parser puede
+// dejar un hijo vacio (else, init/update del for, return solo, variable sin
+// inicializar, tipos): los visitors no esperan nulls en otro lado.
+bool FlatAst::valid() const {
+    size_t exps = expKind.size(), stms = stmKind.size(), bodies = bodyPos.size();
+    size_t types = typeKind.size(), names = nameLen.size(), funs = funPos.size();
+    if (expPos.size() != exps || expA.size() != exps || expB.size() != exps || expC.size() != exps ||
+        stmPos.size() != stms || stmA.size() != stms || stmB.size() != stms ||
+        stmC.size() != stms || stmD.size() != stms ||
+        varInit.size() != varName.size() || typeName.size() != types ||
+        bodyVarDecs.size() != bodies || bodyStmts.size() != bodies ||
+        structName.size() != structPos.size() || structFields.size() != structPos.size() ||
+        funName.size() != funs || funRType.size() != funs || funBody.size() != funs ||
+        funParams.size() != funs || paramName.size() != paramType.size() ||
+        nameStart.size() != names) {
+        return false;
+    }
+
+    auto inRange = [](uint32_t first, uint32_t count, size_t n) {
+        return (uint64_t)first + count <= n;
+    };
+    // Hijo anterior a before (optional: o ausente)
+    auto child = [](NodeRef ref, size_t before) { return ref < before; };
+    auto optional = [](NodeRef ref, size_t before) { return ref == NO_NODE || ref < before; };
+    auto typeRef = [&](NodeRef t) { return t == NO_NODE || t < types; };
+    auto varDecs = [&](Range r) {
+        if (!inRange(r.first, r.count, refs.size())) return false;
+        for (NodeRef s : children(r)) {
+            if (s >= stms || stmKind[s] != VAR_DEC) return false;
+        }
+        return true;
+    };
+
+    for (size_t i = 0; i < names; i++) {
+        if (!inRange(nameStart[i], nameLen[i], text.size())) return false;
+    }
+    for (size_t t = 0; t < types; t++) {
+        if (typeKind[t] > TypeDecl::ID_TYPE || (typeName[t] != NO_NODE && typeName[t] >= names)) {
+            return false;
+        }
+    }
+
+    for (size_t e = 0; e < exps; e++) {
+        uint32_t a = expA[e], b = expB[e], c = expC[e];
+        switch (expKind[e]) {
+            case BINARY_EXP:
+                if (!child(a, e) || !child(b, e) || c > NE_OP) return false;
+                break;
+            case NUMBER_EXP:
+            case FLOAT_EXP:
+            case BOOL_EXP:
+                break;
+            case ID_EXP:
+            case STRING_EXP:
+                if (a >= names) return false;
+                break;
+            case FCALL_EXP:
+                if (a >= names || !inRange(b, c, refs.size())) return false;
+                for (uint32_t i = b; i < b + c; i++) {
+                    if (!child(refs[i], e)) return false;
+                }
+                break;
+            case TERNARY_EXP:
+                if (!child(a, e) || !child(b, e) || !child(c, e)) return false;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    vector<size_t> stmEnd(bodies, 0);
+    for (size_t b = 0; b < bodies; b++) {
+        Range stmts = bodyStmts[b];
+        if (!varDecs(bodyVarDecs[b]) || !inRange(stmts.first, stmts.count, refs.size())) return false;
+        for (NodeRef s : children(bodyVarDecs[b])) {
+            stmEnd[b] = max(stmEnd[b], (size_t)s + 1);
+        }
+        for (NodeRef s : children(stmts)) {
+            if (!child(s, stms)) return false;
+            stmEnd[b] = max(stmEnd[b], (size_t)s + 1);
+        }
+    }
+    auto body = [&](NodeRef b, size_t before) { return b < bodies && stmEnd[b] <= before; };
+
+    for (size_t s = 0; s < stms; s++) {
+        uint32_t a = stmA[s], b = stmB[s], c = stmC[s], d = stmD[s];
+        switch (stmKind[s]) {
+            case VAR_DEC:
+                if (!typeRef(a) || !inRange(b, c, varName.size())) return false;
+                for (uint32_t i = b; i < b + c; i++) {
+                    if (varName[i] >= names || !optional(varInit[i], exps)) return false;
+                }
+                break;
+            case ASSIGN_STM:
+                if (a >= names || !child(b, exps)) return false;
+                break;
+            case PRINT_STM:
+                if (!inRange(b, c, refs.size())) return false;
+                for (uint32_t i = b; i < b + c; i++) {
+                    if (!child(refs[i], exps)) return false;
+                }
+                break;
+            case IF_STM:
+                if (!child(a, exps) || !body(b, s) || (c != NO_NODE && !body(c, s))) return false;
+                break;
+            case WHILE_STM:
+                if (!child(a, exps) || !body(b, s)) return false;
+                break;
+            case FOR_STM:
+                // el update se reconstruye como AssignStm
+                if (!optional(a, s) || !child(b, exps) || !body(d, s) ||
+                    (c != NO_NODE && (c >= s || stmKind[c] != ASSIGN_STM))) {
+                    return false;
+                }
+                break;
+            case RETURN_STM:
+                if (!optional(a, exps)) return false;
+                break;
+            case FCALL_STM:
+                if (a >= exps || expKind[a] != FCALL_EXP) return false;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    if (!varDecs(globals)) return false;
+    for (size_t i = 0; i < structPos.size(); i++) {
+        if (structName[i] >= names || !varDecs(structFields[i])) return false;
+    }
+    for (size_t f = 0; f < funs; f++) {
+        Range params = funParams[f];
+        if (funName[f] >= names || !typeRef(funRType[f]) || !body(funBody[f], stms) ||
+            !inRange(params.first, params.count, paramType.size())) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < paramType.size(); i++) {
+        if (!typeRef(paramType[i]) || paramName[i] >= names) return false;
+    }
+    return true;
+}
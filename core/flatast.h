@@ -0,0 +1,195 @@
+#ifndef FLATAST_H
+#define FLATAST_H
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "ast.h"
+
+using namespace std;
+
+// Indice de 32 bits a un nodo del FlatAst (NO_NODE = hijo ausente)
+typedef uint32_t NodeRef;
+const NodeRef NO_NODE = UINT32_MAX;
+
+// Arreglo de un FlatAst: propio mientras se construye, o vista sobre memoria
+// ajena (un snapshot mapeado, ver FlatAst::attach). Leer es igual en ambos
+// casos: puntero + largo.
+template <typename T>
+class Column {
+private:
+    vector<T> owned;
+    const T* ptr = nullptr;
+    size_t n = 0;
+
+    void sync() { ptr = owned.data(); n = owned.size(); }
+
+public:
+    typedef T value_type;
+
+    Column() = default;
+    Column(const Column&) = delete;
+    Column& operator=(const Column&) = delete;
+    Column(Column&&) = default;
+    Column& operator=(Column&&) = default;
+
+    void push_back(const T& value) { owned.push_back(value); sync(); }
+    template <typename It>
+    void append(It first, It last) { owned.insert(owned.end(), first, last); sync(); }
+    void attach(const T* data, size_t count) {
+        owned = vector<T>();
+        ptr = data;
+        n = count;
+    }
+
+    const T& operator[](size_t i) const { return ptr[i]; }
+    size_t size() const { return n; }
+    const T* data() const { return ptr; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + n; }
+};
+
+// AST plano: cada tipo de nodo vive en arreglos contiguos (struct-of-arrays),
+// los hijos se referencian por indice y las listas (sentencias de un Body,
+// argumentos, campos...) son rangos contiguos dentro de 'refs'. Recorrerlo
+// no persigue punteros ni hace llamadas virtuales.
+class FlatAst {
+public:
+    enum ExpKind : uint8_t {
+        BINARY_EXP,   // a = izq, b = der, c = BinaryOp
+        NUMBER_EXP,   // a = valor (int)
+        FLOAT_EXP,    // a/b = bits del double (parte baja/alta)
+        ID_EXP,       // a = nombre
+        BOOL_EXP,     // a = 0 / 1
+        STRING_EXP,   // a = nombre (texto del literal)
+        FCALL_EXP,    // a = nombre, b/c = rango de argumentos en refs
+        TERNARY_EXP   // a = condicion, b = then, c = else
+    };
+
+    enum StmKind : uint8_t {
+        VAR_DEC,      // a = tipo, b/c = rango en varName/varInit
+        ASSIGN_STM,   // a = nombre, b = rhs
+        PRINT_STM,    // b/c = rango de argumentos en refs
+        IF_STM,       // a = condicion, b = then (Body), c = else (Body)
+        WHILE_STM,    // a = condicion, b = body
+        FOR_STM,      // a = init, b = condicion, c = update, d = body
+        RETURN_STM,   // a = expresion
+        FCALL_STM     // a = FCALL_EXP
+    };
+
+    struct Range {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+
+    // Expresiones
+    Column<uint8_t> expKind;
+    Column<uint32_t> expPos;
+    Column<uint32_t> expA, expB, expC;
+
+    // Sentencias
+    Column<uint8_t> stmKind;
+    Column<uint32_t> stmPos;
+    Column<uint32_t> stmA, stmB, stmC, stmD;
+
+    // Variables de cada VAR_DEC
+    Column<uint32_t> varName;
+    Column<NodeRef> varInit;
+
+    // Tipos (typeName = NO_NODE si no tiene nombre)
+    Column<uint8_t> typeKind;
+    Column<uint32_t> typeName;
+
+    // Bodies: rangos de VAR_DEC y de sentencias en refs
+    Column<uint32_t> bodyPos;
+    Column<Range> bodyVarDecs;
+    Column<Range> bodyStmts;
+
+    // Structs y funciones
+    Column<uint32_t> structPos, structName;
+    Column<Range> structFields;
+    Column<uint32_t> funPos, funName;
+    Column<NodeRef> funRType, funBody;
+    Column<Range> funParams; // rango en paramType/paramName
+    Column<NodeRef> paramType;
+    Column<uint32_t> paramName;
+
+    // VAR_DEC globales, en orden
+    Range globals;
+
+    // Listas de hijos
+    Column<NodeRef> refs;
+
+    // Nombres distintos: texto concatenado + (inicio, largo)
+    Column<char> text;
+    Column<uint32_t> nameStart, nameLen;
+
+    struct Span {
+        const NodeRef* first;
+        const NodeRef* last;
+        const NodeRef* begin() const { return first; }
+        const NodeRef* end() const { return last; }
+    };
+    Span children(Range r) const {
+        return Span{refs.data() + r.first, refs.data() + r.first + r.count};
+    }
+    string_view name(uint32_t id) const {
+        return string_view(text.data() + nameStart[id], nameLen[id]);
+    }
+    SymbolId symbol(uint32_t id) const { // interna el nombre en la tabla global
+        if (symbolCache.size() != nameLen.size()) {
+            symbolCache.assign(nameLen.size(), NO_SYMBOL);
+        }
+        SymbolId& sym = symbolCache[id];
+        if (sym == NO_SYMBOL) {
+            sym = SymbolTable::global().intern(name(id));
+        }
+        return sym;
+    }
+    size_t functionCount() const { return funName.size(); }
+    size_t nodeCount() const {
+        return expKind.size() + stmKind.size() + bodyPos.size() +
+               typeKind.size() + structName.size() + funName.size();
+    }
+
+    // Aplana un Program ya parseado (el FlatAst no depende de el despues)
+    void build(Program* prog);
+
+    // Reconstruye el AST de punteros en Arena::current(); los nombres apuntan
+    // al texto de este FlatAst, que debe seguir vivo mientras se use, y los
+    // ids se obtienen internandolos en SymbolTable::global().
+    Program* raise() const;
+
+    // Snapshot binario: solo hay indices y rangos, asi que no depende de la
+    // direccion donde se cargue. serialize() escribe a partir de una posicion
+    // alineada a 8; attach() deja las columnas apuntando dentro de data (sin
+    // copiar, data debe seguir vivo y alineado a 8) y devuelve false si no
+    // cierra o si algun indice no es valido.
+    void serialize(ostream& out) const;
+    bool attach(const char* data, size_t size);
+
+private:
+    unordered_map<string_view, uint32_t> nameIds; // solo durante build()
+    vector<uint32_t> nameBySymbol;                // idem, por SymbolId
+    mutable vector<SymbolId> symbolCache;         // id de nombre -> SymbolId
+
+    uint32_t addName(string_view s);
+    uint32_t addName(string_view s, SymbolId sym);
+    NodeRef addType(TypeDecl* type);
+    Range addRefs(const vector<NodeRef>& list);
+
+    template <typename Self, typename F>
+    static void forEachColumn(Self& self, F f);
+
+    TypeDecl* raiseType(NodeRef t) const;
+    bool valid() const; // indices y rangos de un snapshot recien adjuntado
+
+    // build() y raise() recorren con una pila de trabajo explicita
+    class Builder;
+    class Raiser;
+};
+
+#endif // FLATAST_H
@@ -0,0 +1,386 @@
+#include "incremental.h"
+#include "parser.h"
+#include "scanner.h"
+#include "visitor.h"
+
+using namespace std;
+
+// Suma delta a los pos de un subarbol reutilizado que quedo despues del cambio
+class PosShifter : public Visitor {
+private:
+    int64_t delta;
+
+    void shift(uint32_t& pos) { pos = (uint32_t)(pos + delta); }
+    void exp(Exp* e) { if (e) e->accept(this); }
+    void body(Body* b) { if (b) b->accept(this); }
+
+public:
+    PosShifter(int64_t delta) : delta(delta) { }
+
+    int visit(BinaryExp* e) override { shift(e->pos); exp(e->left); exp(e->right); return 0; }
+    int visit(NumberExp* e) override { shift(e->pos); return 0; }
+    int visit(FloatExp* e) override { shift(e->pos); return 0; }
+    int visit(IdExp* e) override { shift(e->pos); return 0; }
+    int visit(BoolExp* e) override { shift(e->pos); return 0; }
+    int visit(StringExp* e) override { shift(e->pos); return 0; }
+    int visit(FcallExp* e) override {
+        shift(e->pos);
+        for (Exp* arg : e->args) exp(arg);
+        return 0;
+    }
+    int visit(TernaryExp* e) override {
+        shift(e->pos);
+        exp(e->condition); exp(e->thenExp); exp(e->elseExp);
+        return 0;
+    }
+    int visit(VarDec* vd) override {
+        shift(vd->pos);
+        for (auto& var : vd->vars) exp(var.init_value);
+        return 0;
+    }
+    int visit(StructDec* sd) override {
+        shift(sd->pos);
+        for (VarDec* field : sd->fields) field->accept(this);
+        return 0;
+    }
+    int visit(FunDec* fd) override { shift(fd->pos); body(fd->body); return 0; }
+    int visit(AssignStm* stm) override { shift(stm->pos); exp(stm->rhs); return 0; }
+    int visit(PrintStm* stm) override {
+        shift(stm->pos);
+        for (Exp* arg : stm->args) exp(arg);
+        return 0;
+    }
+    int visit(IfStm* stm) override {
+        shift(stm->pos);
+        exp(stm->condition); body(stm->thenbody); body(stm->elsebody);
+        return 0;
+    }
+    int visit(WhileStm* stm) override {
+        shift(stm->pos);
+        exp(stm->condition); body(stm->body);
+        return 0;
+    }
+    int visit(ForStm* stm) override {
+        shift(stm->pos);
+        if (stm->init) stm->init->accept(this);
+        exp(stm->condition);
+        if (stm->update) stm->update->accept(this);
+        body(stm->body);
+        return 0;
+    }
+    int visit(ReturnStm* stm) override { shift(stm->pos); exp(stm->expr); return 0; }
+    int visit(FcallStm* stm) override { shift(stm->pos); exp(stm->fcall); return 0; }
+    int visit(Body* b) override {
+        shift(b->pos);
+        for (VarDec* vd : b->vardecs) vd->accept(this);
+        for (Stm* stm : b->stmts) stm->accept(this);
+        return 0;
+    }
+    int visit(Program*) override { return 0; }
+};
+
+// FNV-1a sobre offset (relativo al primer token), tipo y texto de cada
+// token: no depende de donde este la declaracion, pero si cambia un blanco
+// interno cambian los pos de sus nodos. El tipo del token siguiente entra
+// porque el parser lo mira para decidir donde termina la declaracion.
+static uint64_t fingerprint(const vector<Token>& toks, size_t first, size_t count) {
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](uint8_t byte) {
+        h ^= byte;
+        h *= 1099511628211ULL;
+    };
+    for (size_t i = first; i < first + count; i++) {
+        uint32_t offset = toks[i].pos - toks[first].pos;
+        for (int b = 0; b < 32; b += 8) mix((uint8_t)(offset >> b));
+        mix((uint8_t)toks[i].type);
+        for (char c : toks[i].text) mix((uint8_t)c);
+        mix(0);
+    }
+    mix((uint8_t)toks[first + count].type);
+    return h;
+}
+
+const vector<Token>& IncrementalParser::itemTokens(Item& item) {
+    if (item.tokenShift != 0 || item.base != text.data()) {
+        for (Token& tok : item.tokens) {
+            tok.pos = (uint32_t)(tok.pos + item.tokenShift);
+            tok.text = string_view(text.data() + tok.pos, tok.text.size());
+        }
+        item.tokenShift = 0;
+        item.base = text.data();
+    }
+    return item.tokens;
+}
+
+Token IncrementalParser::endToken() const {
+    Token tok(Token::END);
+    tok.pos = (uint32_t)text.size();
+    tok.text = string_view(text.data() + text.size(), 0);
+    return tok;
+}
+
+vector<Token> IncrementalParser::tokens() {
+    vector<Token> all;
+    for (Item& item : items) {
+        const vector<Token>& toks = itemTokens(item);
+        all.insert(all.end(), toks.begin(), toks.end());
+    }
+    all.push_back(endToken());
+    return all;
+}
+
+IncrementalParser::Item IncrementalParser::parseItem(Parser& parser, const vector<Token>& toks,
+                                                     Program* scratch) {
+    Item item;
+    size_t first = parser.position();
+    size_t vardecs = scratch->vardecs.size();
+    size_t structdecs = scratch->structdecs.size();
+    size_t fundecs = scratch->fundecs.size();
+
+    parser.parseTopLevel(scratch);
+
+    size_t count = parser.position() - first;
+    item.tokens.assign(toks.begin() + first, toks.begin() + first + count);
+    item.start = item.tokens.front().pos;
+    item.end = item.tokens.back().pos + item.tokens.back().text.size();
+    item.fingerprint = fingerprint(toks, first, count);
+    item.kind = ITEM_NONE;
+    item.node = nullptr;
+    item.shift = 0;
+    item.tokenShift = 0;
+    item.base = text.data();
+    if (scratch->vardecs.size() != vardecs) {
+        item.kind = ITEM_VARDEC;
+        item.node = scratch->vardecs.back();
+    } else if (scratch->structdecs.size() != structdecs) {
+        item.kind = ITEM_STRUCT;
+        item.node = scratch->structdecs.back();
+    } else if (scratch->fundecs.size() != fundecs) {
+        item.kind = ITEM_FUNDEC;
+        item.node = scratch->fundecs.back();
+    }
+    return item;
+}
+
+void IncrementalParser::parse(string source) {
+    text = move(source);
+    items.clear();
+    arena.release();
+    vector<Token> toks = Scanner(text).scanAll();
+
+    Parser parser(toks, arena);
+    ArenaScope scope(arena);
+    Program* scratch = new Program();
+    while (!parser.isAtEnd()) {
+        items.push_back(parseItem(parser, toks, scratch));
+    }
+    liveBytes = arena.bytesUsed();
+
+    last = Stats();
+    last.relexedTokens = toks.size();
+    last.reparsedItems = items.size();
+    last.full = true;
+}
+
+void IncrementalParser::edit(size_t start, size_t oldLength, string_view replacement) {
+    size_t oldEnd = start + oldLength;
+    int64_t delta = (int64_t)replacement.size() - (int64_t)oldLength;
+
+    // Declaraciones tocadas: [lo, hi). Los bordes cuentan, un token pegado
+    // al cambio puede fusionarse con el texto nuevo.
+    size_t lo = lower_bound(items.begin(), items.end(), start,
+        [](const Item& item, size_t off) { return item.end < off; }) - items.begin();
+    size_t hi = upper_bound(items.begin() + lo, items.end(), oldEnd,
+        [](size_t off, const Item& item) { return off < item.start; }) - items.begin();
+
+    // Se re-escanea desde un punto donde seguro empieza un token: el inicio
+    // de la primera declaracion tocada o el final de la anterior (entre
+    // declaraciones solo hay blancos y comentarios)
+    size_t regionStart;
+    if (lo < hi && items[lo].start <= start) {
+        regionStart = items[lo].start;
+    } else {
+        regionStart = lo > 0 ? items[lo - 1].end : 0;
+    }
+    int64_t regionEnd = start + replacement.size();
+    if (lo < hi) {
+        regionEnd = max<int64_t>(regionEnd, items[hi - 1].end + delta);
+    }
+
+    text.replace(start, oldLength, replacement);
+
+    // Re-escaneo hasta pasar el cambio y caer justo en el inicio de una
+    // declaracion vieja (corrida por delta): desde ahi los tokens son iguales
+    vector<Token> fresh;
+    size_t k = hi;
+    Scanner scanner(string_view(text).substr(regionStart), regionStart);
+    while (true) {
+        Token tok = scanner.nextToken();
+        if (tok.type == Token::END) {
+            k = items.size();
+            break;
+        }
+        if ((int64_t)tok.pos >= regionEnd) {
+            while (k < items.size() && (int64_t)items[k].start + delta < (int64_t)tok.pos) {
+                k++;
+            }
+            if (k < items.size() && (int64_t)items[k].start + delta == (int64_t)tok.pos) {
+                break;
+            }
+        }
+        fresh.push_back(tok);
+    }
+
+    // La declaracion anterior miro el primer token de la zona para decidir
+    // donde terminaba: si cambio de tipo tambien se re-parsea
+    Token::Type oldNext = lo < items.size() ? items[lo].tokens[0].type : Token::END;
+    Token::Type newNext = !fresh.empty() ? fresh[0].type
+                        : k < items.size() ? items[k].tokens[0].type : Token::END;
+    bool lowered = lo > 0 && newNext != oldNext;
+    if (lowered) {
+        lo--;
+    }
+
+    // Los offsets viejos de las declaraciones tocadas, para reconocerlas
+    // por posicion y huella al re-parsear
+    vector<int64_t> oldPos, oldStart;
+    for (size_t i = lo; i < hi; i++) {
+        uint64_t s = items[i].start;
+        oldPos.push_back(s);
+        oldStart.push_back(s < start ? (int64_t)s : s >= oldEnd ? (int64_t)(s + delta) : -1);
+    }
+
+    for (size_t i = k; i < items.size(); i++) {
+        Item& item = items[i];
+        item.start += delta;
+        item.end += delta;
+        item.tokenShift += delta;
+        item.shift += delta;
+    }
+
+    // Re-parseo de la zona sobre un vector con sus tokens y los de algunas
+    // declaraciones siguientes. Si una declaracion se come el inicio de la
+    // siguiente (por ejemplo al borrar una '}') esa tambien se re-parsea, y
+    // si llega al final de lo copiado se reintenta con el doble.
+    ArenaScope scope(arena);
+    vector<Item> region;
+    size_t stop = items.size(); // primera declaracion vieja que se conserva
+    for (size_t extra = 1; ; extra *= 2) {
+        vector<Token> toks;
+        if (lowered) {
+            const vector<Token>& prev = itemTokens(items[lo]);
+            toks.insert(toks.end(), prev.begin(), prev.end());
+        }
+        toks.insert(toks.end(), fresh.begin(), fresh.end());
+        vector<size_t> bounds; // donde empieza cada declaracion copiada
+        size_t upto = min(items.size(), k + extra);
+        for (size_t m = k; m < upto; m++) {
+            bounds.push_back(toks.size());
+            const vector<Token>& next = itemTokens(items[m]);
+            toks.insert(toks.end(), next.begin(), next.end());
+        }
+        toks.push_back(endToken());
+
+        last = Stats();
+        last.relexedTokens = fresh.size();
+        region.clear();
+        Parser parser(toks, arena);
+        Program* scratch = new Program();
+        size_t b = 0;
+        size_t j = lo;
+        bool truncated = false;
+        while (true) {
+            size_t i = parser.position();
+            while (b < bounds.size() && bounds[b] < i) {
+                b++;
+            }
+            if (b < bounds.size() && bounds[b] == i) {
+                stop = k + b;
+                break;
+            }
+            if (i == toks.size() - 1) {
+                truncated = upto < items.size();
+                stop = items.size();
+                break;
+            }
+
+            size_t limit = b < bounds.size() ? bounds[b] : toks.size() - 1;
+            while (j < hi && oldStart[j - lo] < (int64_t)toks[i].pos) {
+                j++;
+            }
+            if (j < hi && oldStart[j - lo] == (int64_t)toks[i].pos) {
+                const Item& old = items[j];
+                size_t count = old.tokens.size();
+                if (i + count <= limit && fingerprint(toks, i, count) == old.fingerprint) {
+                    Item item;
+                    item.tokens.assign(toks.begin() + i, toks.begin() + i + count);
+                    item.start = toks[i].pos;
+                    item.end = item.tokens.back().pos + item.tokens.back().text.size();
+                    item.fingerprint = old.fingerprint;
+                    item.kind = old.kind;
+                    item.node = old.node;
+                    item.shift = old.shift + oldStart[j - lo] - oldPos[j - lo];
+                    item.tokenShift = 0;
+                    item.base = text.data();
+                    region.push_back(move(item));
+                    parser.seek(i + count);
+                    last.reusedItems++;
+                    continue;
+                }
+            }
+            region.push_back(parseItem(parser, toks, scratch));
+            last.reparsedItems++;
+        }
+        if (!truncated) {
+            break;
+        }
+    }
+
+    items.erase(items.begin() + lo, items.begin() + stop);
+    items.insert(items.begin() + lo, make_move_iterator(region.begin()),
+                 make_move_iterator(region.end()));
+    last.keptItems = items.size() - region.size();
+
+    // Lo reemplazado sigue ocupando el arena: si ya pesa mas que el AST vivo
+    // se parsea todo de nuevo para liberarlo
+    if (arena.bytesUsed() > 2 * liveBytes + (1 << 20)) {
+        Stats stats = last;
+        parse(move(text));
+        last.relexedTokens += stats.relexedTokens;
+    }
+}
+void IncrementalParser::update(string source) {
+    size_t prefix = 0;
+    size_t n = min(text.size(), source.size());
+    while (prefix < n && text[prefix] == source[prefix]) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < n - prefix &&
+           text[text.size() - 1 - suffix] == source[source.size() - 1 - suffix]) {
+        suffix++;
+    }
+    edit(prefix, text.size() - prefix - suffix,
+         string_view(source).substr(prefix, source.size() - prefix - suffix));
+}
+
+Program* IncrementalParser::program() {
+    ArenaScope scope(arena);
+    Program* prog = new Program();
+    for (Item& item : items) {
+        if (item.shift != 0 && item.node) {
+            PosShifter shifter(item.shift);
+            if (item.kind == ITEM_VARDEC) static_cast<VarDec*>(item.node)->accept(&shifter);
+            if (item.kind == ITEM_STRUCT) static_cast<StructDec*>(item.node)->accept(&shifter);
+            if (item.kind == ITEM_FUNDEC) static_cast<FunDec*>(item.node)->accept(&shifter);
+        }
+        item.shift = 0;
+        switch (item.kind) {
+            case ITEM_VARDEC: prog->vardecs.push_back(static_cast<VarDec*>(item.node)); break;
+            case ITEM_STRUCT: prog->structdecs.push_back(static_cast<StructDec*>(item.node)); break;
+            case ITEM_FUNDEC: prog->fundecs.push_back(static_cast<FunDec*>(item.node)); break;
+            case ITEM_NONE: break;
+        }
+    }
+    return prog;
+}
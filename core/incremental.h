@@ -0,0 +1,80 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "token.h"
+#include "ast.h"
+#include "arena.h"
+
+using namespace std;
+
+class Parser;
+
+// Reparseo incremental para el editor: guarda el fuente y, por cada
+// declaracion de nivel superior, sus tokens y su AST. Ante un cambio se
+// re-escanea solo desde la declaracion tocada hasta que los tokens vuelven a
+// coincidir con los viejos, se re-parsean solo esas declaraciones y el resto
+// se reutiliza tal cual. Dentro de la zona re-escaneada una declaracion cuya
+// huella (hash de sus tokens) no cambio tampoco se vuelve a parsear.
+//
+// Las declaraciones que quedan despues del cambio no se tocan: el corrimiento
+// de sus offsets queda pendiente y se aplica a los tokens cuando se vuelven a
+// leer y a los pos del AST en program().
+class IncrementalParser {
+public:
+    enum ItemKind { ITEM_NONE, ITEM_VARDEC, ITEM_STRUCT, ITEM_FUNDEC };
+
+    // Lo que consume una vuelta de Parser::parseTopLevel
+    struct Item {
+        vector<Token> tokens;
+        uint64_t start, end;  // bytes que ocupa en el texto actual
+        uint64_t fingerprint; // offsets relativos, tipos y texto de los tokens
+        ItemKind kind;
+        void* node;           // VarDec*, StructDec* o FunDec* segun kind
+        int64_t shift;        // pendiente en los pos del subarbol
+        int64_t tokenShift;   // pendiente en los pos de tokens
+        const char* base;     // text.data() cuando se ajustaron los tokens
+    };
+
+    struct Stats {
+        size_t relexedTokens = 0;
+        size_t reparsedItems = 0;
+        size_t reusedItems = 0;   // dentro de la zona re-escaneada, por huella
+        size_t keptItems = 0;     // fuera de la zona, sin tocar
+        bool full = false;        // se parseo todo de nuevo
+    };
+
+    void parse(string source);
+
+    // Reemplaza source[start, start + oldLength) por replacement
+    void edit(size_t start, size_t oldLength, string_view replacement);
+
+    // Cambio minimo (prefijo y sufijo comunes) entre el fuente actual y otro
+    void update(string source);
+
+    // AST completo, en orden de fuente. Valido hasta el siguiente parse/edit.
+    Program* program();
+
+    // Todos los tokens, terminados en END (arma el vector completo)
+    vector<Token> tokens();
+
+    const string& source() const { return text; }
+    const Stats& stats() const { return last; }
+    size_t itemCount() const { return items.size(); }
+
+private:
+    string text;
+    vector<Item> items; // cubren todos los tokens salvo END, en orden
+    Arena arena;
+    size_t liveBytes = 0; // arena usado tras el ultimo parse completo
+    Stats last;
+
+    const vector<Token>& itemTokens(Item& item);
+    Token endToken() const;
+    Item parseItem(Parser& parser, const vector<Token>& toks, Program* scratch);
+};
+
+#endif // INCREMENTAL_H
@@ -1,47 +1,289 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "source.h"
 #include "scanner.h"
 #include "token.h"
 #include "parser.h"
 #include "ast.h"
 #include "visitor.h"
+#include "flatast.h"
+#include "incremental.h"
+#include "astcache.h"
+#include "preprocessor.h"
 
 using namespace std;
 
+static int escanear_streaming(string inputFile, TokenFormat tokenFormat) {
+    int fd = (inputFile == "-") ? STDIN_FILENO : open(inputFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "Error: No se pudo abrir el archivo " << inputFile << endl;
+        return 1;
+    }
+    if (inputFile == "-") {
+        inputFile = "stdin";
+    }
+
+    Scanner scanner(fd);
+    if (tokenFormat != TokenFormat::NONE) {
+        ejecutar_scanner(&scanner, inputFile, tokenFormat);
+    } else {
+        uint64_t count = 0;
+        while (scanner.nextToken().type != Token::END) {
+            scanner.release();
+            count++;
+        }
+        cout << "Tokens: " << count << endl;
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return 0;
+}
+
+static string archivo_salida(const string& inputFile) {
+    string baseName = inputFile;
+    size_t dotPos = baseName.find_last_of('.');
+    if (dotPos != string::npos) {
+        baseName = baseName.substr(0, dotPos);
+    }
+    return baseName + ".s";
+}
+
+// Compilacion por declaracion: cada funcion se parsea, se chequea, se emite
+// y se libera antes de leer la siguiente; en memoria solo queda la tabla de
+// simbolos y lo que necesita el final del asm (globales y cadenas)
+static int compilar_streaming(string inputFile, bool frameSizes, bool rangeStats) {
+    int fd = (inputFile == "-") ? STDIN_FILENO : open(inputFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "Error: No se pudo abrir el archivo " << inputFile << endl;
+        return 1;
+    }
+    if (inputFile == "-") {
+        inputFile = "stdin";
+    }
+
+    string outputFilename = archivo_salida(inputFile);
+    ofstream outfile(outputFilename);
+    if (!outfile.is_open()) {
+        cerr << "Error al crear el archivo de salida: " << outputFilename << endl;
+        return 1;
+    }
+    cout << "Generando codigo ensamblador en " << outputFilename << endl;
+
+    Arena arena; // una declaracion a la vez
+    ArenaScope scope(arena); // tambien lo que agrega el Canonicalizer
+    CodeGenerator codigo(outfile);
+
+    // Si la entrada se puede releer, primero los tipos de retorno: una
+    // llamada puede ir antes de la definicion, como en el modo normal
+    bool seekable = lseek(fd, 0, SEEK_CUR) == 0;
+    if (seekable) {
+        Scanner headers(fd);
+        StreamingParser::functionHeaders(headers, arena, [&](TypeDecl* rtype, SymbolId sym) {
+            codigo.declararFuncion(rtype, sym);
+        });
+        arena.reset();
+        lseek(fd, 0, SEEK_SET);
+    }
+
+    Scanner scanner(fd);
+    StreamingParser parser(scanner, arena);
+    if (frameSizes) {
+        codigo.frameSizes = &cout;
+    }
+    if (rangeStats) {
+        codigo.rangeStats = &cout;
+    }
+    codigo.empezar();
+    bool failed = false;
+    while (Program* item = parser.next()) {
+        for (VarDec* vd : item->vardecs) {
+            codigo.generarGlobal(vd);
+        }
+        for (FunDec* fun : item->fundecs) {
+            // Sin la pasada previa (pipe) la llamada ya se emitio como int
+            if (!codigo.generarFuncion(fun)) {
+                cerr << inputFile << ": error: '" << fun->name
+                     << "' se llama antes de su definicion y no devuelve int" << endl;
+                failed = true;
+            }
+        }
+        arena.reset();
+    }
+    codigo.terminar();
+    outfile.close();
+
+    // El archivo solo se vuelve a mirar para ubicar el error
+    if (parser.errorOffset() != UINT64_MAX) {
+        SourceBuffer source;
+        if (fd != STDIN_FILENO && parser.errorOffset() < UINT32_MAX && source.open(inputFile)) {
+            LineTable::Location loc = LineTable(source.view()).locate(parser.errorOffset());
+            cerr << inputFile << ":" << loc.line << ":" << loc.column;
+        } else {
+            cerr << inputFile << ":+" << parser.errorOffset();
+        }
+        cerr << ": error: caracter invalido '" << parser.errorLexeme() << "'" << endl;
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return failed ? 1 : 0;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        cout << "Uso: " << argv[0] << " <archivo_entrada>" << endl;
+    string inputFile;
+    TokenFormat tokenFormat = TokenFormat::NONE;
+    bool streaming = false;
+    bool streamCompile = false;
+    bool sourceMap = false;
+    bool flatAst = false;
+    bool frameSizes = false;
+    bool rangeStats = false;
+    unsigned jobs = 1;
+    string previousFile;
+    string astCacheDir;
+    vector<string> includeDirs;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--tokens" || arg == "--tokens=text") {
+            tokenFormat = TokenFormat::TEXT;
+        } else if (arg == "--tokens=binary") {
+            tokenFormat = TokenFormat::BINARY;
+        } else if (arg == "--tokens=none") {
+            tokenFormat = TokenFormat::NONE;
+        } else if (arg == "--stream") {
+            streaming = true;
+        } else if (arg == "--stream-compile") {
+            streamCompile = true;
+        } else if (arg == "--source-map") {
+            sourceMap = true;
+        } else if (arg == "--flat-ast") {
+            flatAst = true;
+        } else if (arg == "--frame-sizes") {
+            frameSizes = true;
+        } else if (arg == "--range-stats") {
+            rangeStats = true;
+        } else if (arg.rfind("--jobs=", 0) == 0) {
+            jobs = max(1, atoi(arg.c_str() + 7));
+        } else if (arg.rfind("--incremental-from=", 0) == 0) {
+            previousFile = arg.substr(19);
+        } else if (arg.rfind("--ast-cache=", 0) == 0) {
+            astCacheDir = arg.substr(12);
+        } else if (arg.rfind("-I", 0) == 0 && arg.size() > 2) {
+            includeDirs.push_back(arg.substr(2));
+        } else {
+            inputFile = arg;
+        }
+    }
+
+    if (inputFile.empty()) {
+        cout << "Uso: " << argv[0] << " [--tokens=text|binary|none] [--stream] [--stream-compile] [--source-map] [--flat-ast] [--frame-sizes] [--range-stats] [--jobs=N] [--incremental-from=<version_anterior>] [--ast-cache=<dir>] [-I<dir>] <archivo_entrada>" << endl;
         return 1;
     }
 
-    string inputFile = argv[1];
-    ifstream file(inputFile);
-    
-    if (!file.is_open()) {
+    // Modo streaming: solo escaneo, por bloques y con memoria acotada
+    if (streaming) {
+        return escanear_streaming(inputFile, tokenFormat);
+    }
+    if (streamCompile) {
+        return compilar_streaming(inputFile, frameSizes, rangeStats);
+    }
+
+    SourceBuffer source;
+
+    // Archivo mapeado en memoria (o leido completo si es pipe / stdin "-")
+    if (!source.open(inputFile)) {
         cerr << "Error: No se pudo abrir el archivo " << inputFile << endl;
         return 1;
     }
+    if (inputFile == "-") {
+        inputFile = "stdin";
+    }
+
+    // Cache de ASTs: en un acierto no se parsea, y si tampoco se pidieron
+    // los tokens ni siquiera se escanea. La clave es solo el fuente, asi que
+    // no se usa si incluye headers locales.
+    AstCache cache(astCacheDir);
+    FlatAst cached;
+    AstCache::Diagnostic error;
+    if (source.view().find("#include \"") != string_view::npos) {
+        astCacheDir.clear();
+    }
+    bool hit = !astCacheDir.empty() && cache.load(source.view(), cached, error);
+
+    // Una sola pasada del scanner; el volcado y el parser comparten los tokens
+    // Con --jobs=1 el pool no crea hilos
+    ThreadPool pool(jobs);
+    vector<Token> tokens;
+    if (!hit || tokenFormat != TokenFormat::NONE) {
+        if (jobs > 1) {
+            tokens = scanParallel(source.view(), pool);
+        } else {
+            tokens = Scanner(source.view()).scanAll();
+        }
+        ejecutar_scanner(tokens, source.view(), inputFile, tokenFormat);
+    }
 
-    // Leer todo el contenido del archivo
-    string content((istreambuf_iterator<char>(file)),
-                   istreambuf_iterator<char>());
-    file.close();
+    // La tabla de lineas solo se construye si hay algo que reportar
+    LineTable lines(source.view());
+    for (const Token& tok : tokens) {
+        if (tok.type == Token::ERR) {
+            error.pos = tok.pos;
+            error.len = tok.text.size();
+            break;
+        }
+    }
+    if (error.pos != UINT32_MAX) {
+        LineTable::Location loc = lines.locate(error.pos);
+        cerr << inputFile << ":" << loc.line << ":" << loc.column
+             << ": error: caracter invalido '" << source.view().substr(error.pos, error.len) << "'" << endl;
+    }
 
-    // Crear scanner
-    Scanner scanner_scan(content.c_str());
-    ejecutar_scanner(&scanner_scan, inputFile);
-    
-    Scanner scanner_parser(content.c_str());
-    Parser parser(&scanner_parser);
+    // Includes locales, macros y #ifdef sobre los tokens ya escaneados; el
+    // volcado de --tokens queda con los tokens tal como estan en el fuente.
+    // El reparseo incremental trabaja sobre el texto y no pasa por aca.
+    if (!hit && previousFile.empty()) {
+        Preprocessor preprocessor(inputFile);
+        preprocessor.includeDirs = includeDirs;
+        tokens = preprocessor.run(move(tokens));
+        for (const Preprocessor::Diagnostic& d : preprocessor.diagnostics()) {
+            LineTable::Location loc = lines.locate(d.pos);
+            cerr << inputFile << ":" << loc.line << ":" << loc.column << ": error: " << d.message << endl;
+        }
+    }
 
-    Program* program = parser.parseProgram();     
-        string baseName = inputFile;
-        size_t dotPos = baseName.find_last_of('.');
-        if (dotPos != string::npos) {
-            baseName = baseName.substr(0, dotPos);
+    Arena astArena; // todo el AST se libera de una vez al salir
+    IncrementalParser incremental;
+    Program* program = nullptr;
+    if (hit) {
+        // el AST viene del snapshot
+    } else if (!previousFile.empty()) {
+        // Se parsea la version anterior y se aplica la diferencia con la
+        // actual: solo se re-parsean las declaraciones que cambiaron
+        SourceBuffer previous;
+        if (!previous.open(previousFile)) {
+            cerr << "Error: No se pudo abrir el archivo " << previousFile << endl;
+            return 1;
         }
-        string outputFilename = baseName + ".s";
+        incremental.parse(string(previous.view()));
+        incremental.update(string(source.view()));
+        program = incremental.program();
+        const IncrementalParser::Stats& stats = incremental.stats();
+        cout << "Reparseo incremental: " << stats.reparsedItems << " declaraciones re-parseadas, "
+             << stats.reusedItems + stats.keptItems << " reutilizadas" << endl;
+    } else if (jobs > 1) {
+        program = parseParallel(tokens, astArena, pool);
+    } else {
+        program = Parser(tokens, astArena).parseProgram();
+    }
+
+        string outputFilename = archivo_salida(inputFile);
         ofstream outfile(outputFilename);
         if (!outfile.is_open()) {
             cerr << "Error al crear el archivo de salida: " << outputFilename << endl;
@@ -51,8 +293,32 @@ int main(int argc, char* argv[]) {
     cout << "Generando codigo ensamblador en " << outputFilename << endl;
 
     CodeGenerator codigo(outfile);
-    codigo.generar(program);
+    if (sourceMap) {
+        codigo.lines = &lines;
+    }
+    if (frameSizes) {
+        codigo.frameSizes = &cout; // marco de cada funcion antes y despues de compartir slots
+    }
+    if (rangeStats) {
+        codigo.rangeStats = &cout; // operaciones angostadas y comparaciones resueltas
+    }
+    if (hit) {
+        codigo.generar(cached);
+    } else if (flatAst || !astCacheDir.empty()) {
+        FlatAst flat;
+        flat.build(program);
+        if (!astCacheDir.empty()) {
+            cache.store(source.view(), flat, error);
+        }
+        if (flatAst) {
+            astArena.release(); // desde aqui solo se usa la version plana
+            codigo.generar(flat);
+        } else {
+            codigo.generar(program);
+        }
+    } else {
+        codigo.generar(program);
+    }
     outfile.close();
-    delete program;
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+# Lexing paralelo (--jobs=N) contra el scanner serial, en dos niveles:
+#  - scanner_parallel.cpp compara token por token scanParallel() con
+#    scanAll() sobre los inputs y un fuente generado con los casos de borde
+#  - ./a.out con --jobs=N tiene que volcar los mismos tokens (formato binario:
+#    tipo, offset y largo) y generar el mismo ensamblador que con --jobs=1
+# Con --bench mide ademas la escala de 1 a N hilos: solo el lexing
+# (scanner_parallel --bench) y la compilacion completa con ./a.out.
+#
+#   python3 parallel_lex.py [--max-jobs N] [--bench] [--mb M]
+
+FUNCION = """int f{n}(int a, int b) {{
+    int c;
+    c = a * {k} + b;
+    if (c >= 10) {{
+        c = c - 10;
+    }}
+    printf("%d\\n", c);
+    return c;
+}}
+"""
+
+
+def programa(megas):
+    partes = ["#include <stdio.h>\n"]
+    total = 0
+    n = 0
+    while total < megas * (1 << 20):
+        parte = FUNCION.format(n=n, k=n % 97)
+        partes.append(parte)
+        total += len(parte)
+        n += 1
+    partes.append('int main() {\n    printf("%d\\n", f0(1, 2));\n    return 0;\n}\n')
+    return "".join(partes)
+
+
+def compilar(archivo, jobs, extra=()):
+    inicio = time.time()
+    result = subprocess.run(["./a.out", f"--jobs={jobs}", *extra, archivo], capture_output=True)
+    return result.returncode, time.time() - inicio
+
+
+def main():
+    args = argparse.ArgumentParser()
+    args.add_argument("--max-jobs", type=int, default=max(4, os.cpu_count() or 1))
+    args.add_argument("--bench", action="store_true")
+    args.add_argument("--mb", type=int, default=64)
+    opciones = args.parse_args()
+
+    build = ["g++", "-pthread", "-O2", "-o", "scanner_parallel", "scanner_parallel.cpp", "scanner.cpp",
+             "token.cpp", "charclass.cpp", "symbols.cpp", "arena.cpp", "threadpool.cpp"]
+    print("Compilando:", " ".join(build))
+    result = subprocess.run(build, capture_output=True, text=True)
+    if result.returncode != 0:
+        print("Error en compilación:\n", result.stderr)
+        return 1
+
+    if opciones.bench:
+        print(f"Lexing, {opciones.mb} MB:")
+        subprocess.run(["./scanner_parallel", "--bench", f"--mb={opciones.mb}",
+                        f"--max-jobs={opciones.max_jobs}"])
+        with tempfile.TemporaryDirectory() as tmp:
+            archivo = os.path.join(tmp, "escala.txt")
+            with open(archivo, "w") as f:
+                f.write(programa(max(1, opciones.mb // 8)))
+            print(f"Compilacion completa, {os.path.getsize(archivo) / (1 << 20):.1f} MB:")
+            base = None
+            for jobs in range(1, opciones.max_jobs + 1):
+                tiempos = sorted(compilar(archivo, jobs)[1] for _ in range(3))
+                base = base or tiempos[1]
+                print(f"{jobs} hilos: {tiempos[1] * 1000:.0f} ms (x{base / tiempos[1]:.2f})")
+        return 0
+
+    fallas = 0
+    entradas = [os.path.join("inputs", f"input{i}.txt") for i in range(1, 21)]
+    result = subprocess.run(["./scanner_parallel", f"--max-jobs={opciones.max_jobs}"] +
+                            [e for e in entradas if os.path.isfile(e)])
+    fallas += result.returncode != 0
+
+    # Por encima de 64 KB por bloque el compilador reparte de verdad
+    with tempfile.TemporaryDirectory() as tmp:
+        archivo = os.path.join(tmp, "paralelo.txt")
+        with open(archivo, "w") as f:
+            f.write(programa(1))
+        volcados = {}
+        for jobs in range(1, opciones.max_jobs + 1):
+            rc, _ = compilar(archivo, jobs, ["--tokens=binary"])
+            if rc != 0:
+                print(f"Paralelo --jobs={jobs}: rc={rc}")
+                fallas += 1
+                continue
+            with open(os.path.join(tmp, "paralelo_tokens.bin"), "rb") as f:
+                tokens = f.read()
+            with open(os.path.join(tmp, "paralelo.s"), "rb") as f:
+                asm = f.read()
+            volcados[jobs] = (tokens, asm)
+            if jobs > 1 and 1 in volcados:
+                if tokens != volcados[1][0]:
+                    print(f"Paralelo --jobs={jobs}: los tokens cambian")
+                    fallas += 1
+                elif asm != volcados[1][1]:
+                    print(f"Paralelo --jobs={jobs}: el ensamblador cambia")
+                    fallas += 1
+                else:
+                    print(f"Paralelo --jobs={jobs}: ok")
+
+    return 1 if fallas else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
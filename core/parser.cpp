@@ -6,15 +6,10 @@
 
 using namespace std;
 
-Parser::Parser(Scanner* sc) : scanner(sc) {
-    previous = nullptr;
-    current = scanner->nextToken();
-}
+Parser::Parser(const vector<Token>& tokens, Arena& arena)
+    : tokens(tokens), arena(arena), pos(0), current(&tokens[0]), previous(nullptr) { }
 
-Parser::~Parser() {
-    delete previous;
-    delete current;
-}
+Parser::~Parser() { }
 
 bool Parser::match(Token::Type ttype) {
     if (check(ttype)) {
@@ -31,9 +26,8 @@ bool Parser::check(Token::Type ttype) {
 
 bool Parser::advance() {
     if (!isAtEnd()) {
-        delete previous;
         previous = current;
-        current = scanner->nextToken();
+        current = &tokens[++pos];
         return true;
     }
     return false;
@@ -43,15 +37,26 @@ bool Parser::isAtEnd() {
     return current->type == Token::END;
 }
 
-bool Parser::isTypeStart() {
-    if (check(Token::UNSIGNED) || check(Token::STRUCT)) {
-        return true;
-    }
-    if (check(Token::ID)) {
-        string id = current->text;
-        return (id == "int" || id == "float");
+string_view Parser::lexeme() {
+    if (previous->sym != NO_SYMBOL) {
+        return SymbolTable::global().name(previous->sym);
     }
-    return false;
+    return arena.copy(previous->text);
+}
+
+void Parser::seek(size_t index) {
+    pos = index;
+    current = &tokens[index];
+    previous = index > 0 ? &tokens[index - 1] : nullptr;
+}
+
+const Token& Parser::peek(size_t k) const {
+    return pos + k < tokens.size() ? tokens[pos + k] : tokens.back();
+}
+
+bool Parser::isTypeStart() {
+    return check(Token::UNSIGNED) || check(Token::STRUCT) ||
+           check(Token::INT) || check(Token::FLOAT);
 }
 
 bool Parser::isLocalDecl() {
@@ -59,54 +64,71 @@ bool Parser::isLocalDecl() {
 }
 
 Program* Parser::parseProgram() {
+    ArenaScope scope(arena);
     Program* prog = new Program();
 
     while (!isAtEnd()) {
-        if (check(Token::INCLUDE) || check(Token::PREPROCESSOR)) {
-            advance();
-            continue;
-        }
-
-        if (check(Token::STRUCT)) {
-            prog->structdecs.push_back(parseStructDec());
-        } else if (isTypeStart()) {
-            parseGlobalDecl(prog);
-        } else {
-            advance();
-        }
+        parseTopLevel(prog);
     }
     return prog;
 }
 
+// Un elemento de nivel superior: struct, global, funcion, o un token suelto
+// que se descarta
+void Parser::parseTopLevel(Program* prog) {
+    if (check(Token::INCLUDE) || check(Token::PREPROCESSOR)) {
+        advance();
+    } else if (check(Token::STRUCT)) {
+        prog->structdecs.push_back(parseStructDec());
+    } else if (isTypeStart()) {
+        parseGlobalDecl(prog);
+    } else {
+        advance();
+    }
+}
+
 void Parser::parseGlobalDecl(Program* prog) {
+    size_t first = pos;
+    uint32_t start = current->pos;
     TypeDecl* type = parseType();
 
     if (!match(Token::ID)) {
-        delete type;
         return;
     }
 
-    string name = previous->text;
+    string_view name = lexeme();
+
+    SymbolId nameSym = previous->sym;
 
     if (check(Token::LPAREN)) {
-        prog->fundecs.push_back(parseFunDec(type, name));
+        if (deferred) {
+            size_t lparen = pos;
+            if (skipFunctionBody()) {
+                prog->fundecs.push_back(nullptr);
+                deferred->push_back({first, pos, &prog->fundecs.back()});
+                return;
+            }
+            seek(lparen); // prototipo o entrada rota: se parsea aqui mismo
+        }
+        prog->fundecs.push_back(at(start, parseFunDec(type, name, nameSym)));
     } else {
-        VarDec* vd = new VarDec(type);
+        VarDec* vd = at(start, new VarDec(type));
 
         Exp* init_value = nullptr;
         if (match(Token::ASSIGN)) {
             init_value = parseCE();
         }
-        vd->addVar(name, init_value);
+        vd->addVar(name, nameSym, init_value);
 
         while (match(Token::COMA)) {
             if (match(Token::ID)) {
-                string nextVar = previous->text;
+                string_view nextVar = lexeme();
+                SymbolId nextVarSym = previous->sym;
                 Exp* nextInit = nullptr;
                 if (match(Token::ASSIGN)) {
                     nextInit = parseCE();
                 }
-                vd->addVar(nextVar, nextInit);
+                vd->addVar(nextVar, nextVarSym, nextInit);
             }
         }
 
@@ -115,56 +137,222 @@ void Parser::parseGlobalDecl(Program* prog) {
     }
 }
 
+// Salta "( ... ) { ... }" contando llaves. Devuelve false si antes de la
+// primera '{' aparece ';', '}' o el final.
+bool Parser::skipFunctionBody() {
+    while (!check(Token::LBRACE)) {
+        if (isAtEnd() || check(Token::SEMICOL) || check(Token::RBRACE)) {
+            return false;
+        }
+        advance();
+    }
+    int depth = 0;
+    do {
+        if (check(Token::LBRACE)) depth++;
+        else if (check(Token::RBRACE)) depth--;
+        advance();
+    } while (depth > 0 && !isAtEnd());
+    return depth == 0;
+}
+
+// Mismo camino que parseGlobalDecl para una funcion
+FunDec* Parser::parseFunctionAt(size_t index) {
+    ArenaScope scope(arena);
+    seek(index);
+    uint32_t start = current->pos;
+    TypeDecl* type = parseType();
+    match(Token::ID);
+    string_view name = lexeme();
+    SymbolId nameSym = previous->sym;
+    return at(start, parseFunDec(type, name, nameSym));
+}
+
+Program* parseParallel(const vector<Token>& tokens, Arena& arena, ThreadPool& pool) {
+    vector<Parser::DeferredFun> deferred;
+    Parser top(tokens, arena);
+    top.deferred = &deferred;
+    Program* prog = top.parseProgram();
+    if (deferred.empty()) {
+        return prog;
+    }
+
+    size_t batches = min<size_t>(deferred.size(), pool.size() * 4);
+    vector<Arena> arenas(batches);
+    atomic<bool> consistent{true};
+    pool.parallelFor(batches, [&](size_t b) {
+        Parser parser(tokens, arenas[b]);
+        size_t lo = deferred.size() * b / batches;
+        size_t hi = deferred.size() * (b + 1) / batches;
+        for (size_t i = lo; i < hi; i++) {
+            *deferred[i].slot = parser.parseFunctionAt(deferred[i].first);
+            if (parser.position() != deferred[i].last) {
+                consistent = false;
+            }
+        }
+    });
+    for (Arena& a : arenas) {
+        arena.absorb(a);
+    }
+
+    if (!consistent) {
+        return Parser(tokens, arena).parseProgram();
+    }
+    return prog;
+}
+
+// Lee del scanner hasta tener al menos minSize tokens terminando en un ';'
+// o una '}' de nivel superior, mas uno de lookahead (o hasta el final)
+void StreamingParser::fill(size_t minSize) {
+    int depth = 0;
+    for (const Token& tok : buf) {
+        if (tok.type == Token::LBRACE) depth++;
+        else if (tok.type == Token::RBRACE && depth > 0) depth--;
+    }
+    bool boundary = false;
+    while (!done) {
+        Token tok = scanner.nextToken();
+        if (tok.type == Token::END) {
+            done = true;
+            break;
+        }
+        if (tok.type == Token::ERR && errorPos == UINT64_MAX) {
+            errorPos = scanner.tokenOffset();
+            errorText = string(tok.text);
+        }
+        buf.push_back(tok);
+        if (boundary) break; // el lookahead
+        if (tok.type == Token::LBRACE) {
+            depth++;
+        } else if (tok.type == Token::RBRACE) {
+            if (depth > 0) depth--;
+            boundary = depth == 0 && buf.size() >= minSize;
+        } else if (tok.type == Token::SEMICOL) {
+            boundary = depth == 0 && buf.size() >= minSize;
+        }
+    }
+}
+
+// Se parsea sobre lo leido con un END de centinela. Si el parser llega al
+// centinela la declaracion puede seguir mas adelante: se lee el doble y se
+// vuelve a parsear (lo parseado a medias queda en el arena hasta que el
+// llamador lo vacie).
+Program* StreamingParser::next() {
+    ArenaScope scope(arena);
+    if (buf.empty()) {
+        fill(1);
+    }
+    while (!buf.empty()) {
+        Token end(Token::END);
+        end.pos = buf.back().pos + buf.back().text.size();
+        buf.push_back(end);
+
+        Program* prog = new Program();
+        Parser parser(buf, arena);
+        parser.parseTopLevel(prog);
+        size_t used = parser.position();
+        buf.pop_back();
+
+        if (used >= buf.size() && !done) {
+            fill(buf.size() * 2);
+            continue;
+        }
+        buf.erase(buf.begin(), buf.begin() + min(used, buf.size()));
+        // El ultimo token leido vive en la ventana actual del scanner
+        if (buf.size() <= 1) {
+            scanner.release();
+        }
+        return prog;
+    }
+    return nullptr;
+}
+
+void StreamingParser::functionHeaders(Scanner& scanner, Arena& arena,
+                                      const function<void(TypeDecl*, SymbolId)>& f) {
+    ArenaScope scope(arena);
+    vector<Token> head; // nivel superior desde el ultimo ';' o '}'
+    int depth = 0;
+    for (Token tok = scanner.nextToken(); tok.type != Token::END; tok = scanner.nextToken()) {
+        if (tok.type == Token::LBRACE) {
+            depth++;
+            head.clear();
+        } else if (tok.type == Token::RBRACE) {
+            if (depth > 0) depth--;
+        } else if (depth > 0) {
+            // cuerpo: no interesa
+        } else if (tok.type == Token::LPAREN && head.size() >= 2) {
+            // Solo si antes del '(' hay exactamente un tipo y un nombre; un
+            // inicializador de global ('int a = f(') no lo es
+            head.push_back(Token(Token::END));
+            Parser parser(head, arena);
+            TypeDecl* type = parser.parseType();
+            const Token& name = head[head.size() - 2];
+            if (type && parser.position() == head.size() - 2 && name.type == Token::ID) {
+                f(type, name.sym);
+            }
+            head.clear();
+            arena.reset();
+        } else if (tok.type == Token::SEMICOL) {
+            head.clear();
+        } else {
+            head.push_back(tok);
+        }
+        // Los tokens de head pueden apuntar a ventanas anteriores
+        if (head.empty()) {
+            scanner.release();
+        }
+    }
+}
+
 TypeDecl* Parser::parseType() {
     if (match(Token::UNSIGNED)) {
-        if (match(Token::ID)) {
-            return new TypeDecl(TypeDecl::UNSIGNED_TYPE, previous->text);
+        if (match(Token::INT) || match(Token::ID)) {
+            return new TypeDecl(TypeDecl::UNSIGNED_TYPE, lexeme());
         } else {
             return new TypeDecl(TypeDecl::UNSIGNED_TYPE, "int");
         }
     } else if (match(Token::STRUCT)) {
         if (match(Token::ID)) {
-            return new TypeDecl(TypeDecl::STRUCT_TYPE, previous->text);
+            return new TypeDecl(TypeDecl::STRUCT_TYPE, lexeme());
         } else {
             return nullptr;
         }
+    } else if (match(Token::INT)) {
+        return new TypeDecl(TypeDecl::INT_TYPE);
+    } else if (match(Token::FLOAT)) {
+        return new TypeDecl(TypeDecl::FLOAT_TYPE);
     } else if (match(Token::ID)) {
-        string typeName = previous->text;
-        if (typeName == "int") {
-            return new TypeDecl(TypeDecl::INT_TYPE);
-        } else if (typeName == "float") {
-            return new TypeDecl(TypeDecl::FLOAT_TYPE);
-        } else {
-            return new TypeDecl(TypeDecl::ID_TYPE, typeName);
-        }
+        return new TypeDecl(TypeDecl::ID_TYPE, lexeme());
     }
     return nullptr;
 }
 
 VarDec* Parser::parseVarDec() {
+    uint32_t start = current->pos;
     TypeDecl* type = parseType();
-    VarDec* vd = new VarDec(type);
+    VarDec* vd = at(start, new VarDec(type));
 
     if (match(Token::ID)) {
-        string varname = previous->text;
+        string_view varname = lexeme();
+        SymbolId varnameSym = previous->sym;
         Exp* init_value = nullptr;
 
         if (match(Token::ASSIGN)) {
             init_value = parseCE();
         }
 
-        vd->addVar(varname, init_value);
+        vd->addVar(varname, varnameSym, init_value);
 
         while (match(Token::COMA)) {
             if (match(Token::ID)) {
-                string nextVar = previous->text;
+                string_view nextVar = lexeme();
+                SymbolId nextVarSym = previous->sym;
                 Exp* nextInit = nullptr;
 
                 if (match(Token::ASSIGN)) {
                     nextInit = parseCE();
                 }
 
-                vd->addVar(nextVar, nextInit);
+                vd->addVar(nextVar, nextVarSym, nextInit);
             }
         }
     }
@@ -174,15 +362,20 @@ VarDec* Parser::parseVarDec() {
 }
 
 StructDec* Parser::parseStructDec() {
+    uint32_t start = current->pos;
     match(Token::STRUCT);
     StructDec* sd = nullptr;
 
     if (match(Token::ID)) {
-        sd = new StructDec(previous->text);
+        sd = at(start, new StructDec(lexeme()));
         match(Token::LBRACE);
 
         while (!check(Token::RBRACE) && !isAtEnd()) {
+            size_t before = pos;
             sd->fields.push_back(parseVarDec());
+            if (pos == before) {
+                advance(); // un campo que no empieza con tipo ni ';' colgaba el parser
+            }
         }
 
         match(Token::RBRACE);
@@ -196,9 +389,10 @@ FunDec* Parser::parseFunDec() {
     return nullptr;
 }
 
-FunDec* Parser::parseFunDec(TypeDecl* rtype, string name) {
-    vector<TypeDecl*> ptypes;
-    vector<string> pnames;
+FunDec* Parser::parseFunDec(TypeDecl* rtype, string_view name, SymbolId sym) {
+    ArenaVector<TypeDecl*> ptypes;
+    ArenaVector<string_view> pnames;
+    ArenaVector<SymbolId> psyms;
 
     match(Token::LPAREN);
 
@@ -207,7 +401,8 @@ FunDec* Parser::parseFunDec(TypeDecl* rtype, string name) {
             TypeDecl* ptype = parseType();
             if (match(Token::ID)) {
                 ptypes.push_back(ptype);
-                pnames.push_back(previous->text);
+                pnames.push_back(lexeme());
+                psyms.push_back(previous->sym);
             }
         } while (match(Token::COMA));
     }
@@ -216,11 +411,12 @@ FunDec* Parser::parseFunDec(TypeDecl* rtype, string name) {
 
     Body* body = parseBody();
 
-    return new FunDec(rtype, name, ptypes, pnames, body);
+    return new FunDec(rtype, name, sym, move(ptypes), move(pnames), move(psyms), body);
 }
 
-Body* Parser::parseBody() {
-    Body* body = new Body();
+// '{' y las declaraciones; el cuerpo queda abierto en stmFrames
+Body* Parser::openBody() {
+    Body* body = at(current->pos, new Body());
 
     match(Token::LBRACE);
 
@@ -228,15 +424,56 @@ Body* Parser::parseBody() {
         body->vardecs.push_back(parseVarDec());
     }
 
-    while (!check(Token::RBRACE) && !isAtEnd()) {
-        Stm* stm = parseStm();
-        if (stm) {
-            body->stmts.push_back(stm);
+    stmFrames.push_back({BLOCK, nullptr, body});
+    return body;
+}
+
+Body* Parser::parseBody() {
+    size_t base = stmFrames.size();
+    Body* root = openBody();
+
+    while (stmFrames.size() > base) {
+        StmFrame& top = stmFrames.back();
+        if (!check(Token::RBRACE) && !isAtEnd()) {
+            Body* body = top.body;
+            Stm* stm = parseStm();
+            if (stm) {
+                body->stmts.push_back(stm);
+            }
+            continue;
+        }
+
+        match(Token::RBRACE);
+        Body* done = top.body;
+        stmFrames.pop_back();
+        if (stmFrames.size() == base) {
+            break;
+        }
+
+        // El cuerpo cerrado es de un if/while/for
+        StmFrame& owner = stmFrames.back();
+        if (owner.kind == THEN) {
+            static_cast<IfStm*>(owner.stm)->thenbody = done;
+            if (match(Token::ELSE)) {
+                owner.kind = ELSE;
+                openBody();
+            } else {
+                stmFrames.pop_back();
+            }
+        } else if (owner.kind == ELSE) {
+            static_cast<IfStm*>(owner.stm)->elsebody = done;
+            stmFrames.pop_back();
+        } else {
+            if (WhileStm* w = owner.stm->as<WhileStm>()) {
+                w->body = done;
+            } else {
+                static_cast<ForStm*>(owner.stm)->body = done;
+            }
+            stmFrames.pop_back();
         }
     }
 
-    match(Token::RBRACE);
-    return body;
+    return root;
 }
 
 bool Parser::isStatement() {
@@ -246,24 +483,26 @@ bool Parser::isStatement() {
 }
 
 Stm* Parser::parseStm() {
+    uint32_t start = current->pos;
     if (match(Token::IF)) {
-        return parseIfStm();
+        return at(start, parseIfStm());
     } else if (match(Token::WHILE)) {
-        return parseWhileStm();
+        return at(start, parseWhileStm());
     } else if (match(Token::FOR)) {
-        return parseForStm();
+        return at(start, parseForStm());
     } else if (match(Token::RETURN)) {
-        return parseReturnStm();
+        return at(start, parseReturnStm());
     } else if (match(Token::PRINTF)) {
-        return parsePrintStm();
+        return at(start, parsePrintStm());
     } else if (match(Token::ID)) {
-        string id = previous->text;
+        string_view id = lexeme();
+        SymbolId idSym = previous->sym;
         if (match(Token::ASSIGN)) {
             Exp* rhs = parseCE();
             match(Token::SEMICOL);
-            return new AssignStm(id, rhs);
+            return at(start, new AssignStm(id, idSym, rhs));
         } else if (check(Token::LPAREN)) {
-            FcallExp* fcall = new FcallExp(id);
+            FcallExp* fcall = at(start, new FcallExp(id, idSym));
             match(Token::LPAREN);
             if (!check(Token::RPAREN)) {
                 do {
@@ -272,7 +511,7 @@ Stm* Parser::parseStm() {
             }
             match(Token::RPAREN);
             match(Token::SEMICOL);
-            return new FcallStm(fcall);
+            return at(start, new FcallStm(fcall));
         }
     }
 
@@ -284,27 +523,28 @@ Stm* Parser::parseStm() {
     return nullptr;
 }
 
+// if/while/for devuelven el nodo con el cuerpo abierto: lo completa parseBody
+
 Stm* Parser::parseIfStm() {
     match(Token::LPAREN);
     Exp* condition = parseCE();
     match(Token::RPAREN);
-    Body* thenbody = parseBody();
-    Body* elsebody = nullptr;
-
-    if (match(Token::ELSE)) {
-        elsebody = parseBody();
-    }
 
-    return new IfStm(condition, thenbody, elsebody);
+    IfStm* stm = new IfStm(condition, nullptr);
+    stmFrames.push_back({THEN, stm, nullptr});
+    openBody();
+    return stm;
 }
 
 Stm* Parser::parseWhileStm() {
     match(Token::LPAREN);
     Exp* condition = parseCE();
     match(Token::RPAREN);
-    Body* body = parseBody();
 
-    return new WhileStm(condition, body);
+    WhileStm* stm = new WhileStm(condition, nullptr);
+    stmFrames.push_back({LOOP, stm, nullptr});
+    openBody();
+    return stm;
 }
 
 Stm* Parser::parseForStm() {
@@ -312,13 +552,15 @@ Stm* Parser::parseForStm() {
 
     Stm* init = nullptr;
 
+    uint32_t initPos = current->pos;
     if (isLocalDecl()) {
         init = parseVarDec();
     } else if (match(Token::ID)) {
-        string id = previous->text;
+        string_view id = lexeme();
+        SymbolId idSym = previous->sym;
         match(Token::ASSIGN);
         Exp* rhs = parseCE();
-        init = new AssignStm(id, rhs);
+        init = at(initPos, new AssignStm(id, idSym, rhs));
         match(Token::SEMICOL);
     }
 
@@ -326,17 +568,21 @@ Stm* Parser::parseForStm() {
     match(Token::SEMICOL);
 
     AssignStm* update = nullptr;
+    uint32_t updatePos = current->pos;
     if (match(Token::ID)) {
-        string id = previous->text;
+        string_view id = lexeme();
+        SymbolId idSym = previous->sym;
         match(Token::ASSIGN);
         Exp* rhs = parseCE();
-        update = new AssignStm(id, rhs);
+        update = at(updatePos, new AssignStm(id, idSym, rhs));
     }
 
     match(Token::RPAREN);
-    Body* body = parseBody();
 
-    return new ForStm(init, condition, update, body);
+    ForStm* stm = new ForStm(init, condition, update, nullptr);
+    stmFrames.push_back({LOOP, stm, nullptr});
+    openBody();
+    return stm;
 }
 
 Stm* Parser::parseReturnStm() {
@@ -363,98 +609,149 @@ Stm* Parser::parsePrintStm() {
     return pstm;
 }
 
-Exp* Parser::parseCE() {
-    Exp* cond = parseRelExp();
-
-    if (match(Token::QUESTION)) {
-        Exp* thenExp = parseCE();
-        match(Token::COLON);
-        Exp* elseExp = parseCE();
-        return new TernaryExp(cond, thenExp, elseExp);
-    }
-
-    return cond;
-}
-
-Exp* Parser::parseRelExp() {
-    Exp* left = parseE();
-
-    if (match(Token::LT) || match(Token::LE) || match(Token::EQ) ||
-        match(Token::GT) || match(Token::GE)) {
-
-        BinaryOp op;
-        if (previous->type == Token::LT)      op = LT_OP;
-        else if (previous->type == Token::LE) op = LE_OP;
-        else if (previous->type == Token::EQ) op = EQ_OP;
-        else if (previous->type == Token::GT) op = GT_OP;
-        else                                  op = GE_OP;
-
-        Exp* right = parseE();
-        left = new BinaryExp(left, right, op);
-    }
-
-    return left; 
-}
-Exp* Parser::parseBE() {
-    return parseE();
-}
-
-Exp* Parser::parseE() {
-    Exp* left = parseT();
-
-    while (match(Token::PLUS) || match(Token::MINUS)) {
-        BinaryOp op = (previous->type == Token::PLUS) ? PLUS_OP : MINUS_OP;
-        Exp* right = parseT();
-        left = new BinaryExp(left, right, op);
+// Tabla de precedencia de los operadores binarios, indexada por
+// Token::Type (prec 0 = no es binario). Todos asocian a la izquierda; el
+// ternario va aparte, por debajo de todos.
+struct BinaryInfo {
+    int prec = 0;
+    BinaryOp op = PLUS_OP;
+};
+
+struct BinaryTable {
+    BinaryInfo info[Token::END + 1];
+
+    constexpr BinaryTable() : info() {
+        info[Token::EQ]    = {1, EQ_OP};
+        info[Token::NE]    = {1, NE_OP};
+        info[Token::LT]    = {2, LT_OP};
+        info[Token::LE]    = {2, LE_OP};
+        info[Token::GT]    = {2, GT_OP};
+        info[Token::GE]    = {2, GE_OP};
+        info[Token::PLUS]  = {3, PLUS_OP};
+        info[Token::MINUS] = {3, MINUS_OP};
+        info[Token::MUL]   = {4, MUL_OP};
+        info[Token::DIV]   = {4, DIV_OP};
     }
+};
+
+static constexpr BinaryTable binaryTable;
+
+// Expresiones por precedencia de operadores con pilas explicitas: ni los
+// parentesis, ni las llamadas, ni los ternarios anidados recursan, asi que
+// la profundidad de la pila nativa no depende del anidamiento.
+//
+// 'operands' guarda cada subexpresion con el offset donde empezo (incluido
+// un '(' que la envuelva), que es el pos de los nodos que la tienen a la
+// izquierda. 'frames' guarda los operadores binarios pendientes y las
+// barreras: '(', llamada (sus argumentos se juntan en el FcallExp), y las
+// dos mitades del ternario (cond ? [then] : [else]).
+Exp* Parser::parseCE() {
+    typedef ExpFrame Frame;
+    typedef ExpOperand Operand;
+    // Las pilas son miembros para no reservar memoria en cada expresion
+    vector<Frame>& frames = expFrames;
+    vector<Operand>& operands = expOperands;
+    frames.clear();
+    operands.clear();
+
+    // Reduce los binarios del tope con precedencia >= minPrec
+    auto reduceBinary = [&](int minPrec) {
+        while (!frames.empty() && frames.back().kind == BINARY && frames.back().prec >= minPrec) {
+            Operand right = operands.back();
+            operands.pop_back();
+            Operand& left = operands.back();
+            left.exp = at(left.start, new BinaryExp(left.exp, right.exp, frames.back().op));
+            frames.pop_back();
+        }
+    };
+
+    while (true) {
+        // ---- Operando ----
+        uint32_t start = current->pos;
+        if (match(Token::NUM)) {
+            operands.push_back({at(start, new NumberExp(stoi(string(previous->text)))), start});
+        } else if (match(Token::FLOAT_NUM)) {
+            operands.push_back({at(start, new FloatExp(stod(string(previous->text)))), start});
+        } else if (match(Token::STRING)) {
+            operands.push_back({at(start, new StringExp(lexeme(), previous->sym)), start});
+        } else if (match(Token::TRUE)) {
+            operands.push_back({at(start, new BoolExp(true)), start});
+        } else if (match(Token::FALSE)) {
+            operands.push_back({at(start, new BoolExp(false)), start});
+        } else if (match(Token::ID)) {
+            string_view id = lexeme();
+            SymbolId idSym = previous->sym;
+            if (match(Token::LPAREN)) {
+                FcallExp* fcall = at(start, new FcallExp(id, idSym));
+                if (!match(Token::RPAREN)) {
+                    frames.push_back({CALL, PLUS_OP, 0, start, fcall});
+                    continue; // primer argumento
+                }
+                operands.push_back({fcall, start});
+            } else {
+                operands.push_back({at(start, new IdExp(id, idSym)), start});
+            }
+        } else if (match(Token::LPAREN)) {
+            frames.push_back({PAREN, PLUS_OP, 0, start, nullptr});
+            continue;
+        } else {
+            // Sin operando valido: 0 sin consumir nada (asi "-x" es "0 - x")
+            operands.push_back({at(start, new NumberExp(0)), start});
+        }
 
-    return left;
-}
-
-Exp* Parser::parseT() {
-    Exp* left = parseF();
+        // ---- Operadores y cierres hasta necesitar otro operando ----
+        while (true) {
+            const BinaryInfo& bin = binaryTable.info[current->type];
+            if (bin.prec > 0) {
+                reduceBinary(bin.prec);
+                advance();
+                frames.push_back({BINARY, bin.op, bin.prec, operands.back().start, nullptr});
+                break;
+            }
 
-    while (match(Token::MUL) || match(Token::DIV)) {
-        BinaryOp op = (previous->type == Token::MUL) ? MUL_OP : DIV_OP;
-        Exp* right = parseF();
-        left = new BinaryExp(left, right, op);
-    }
+            reduceBinary(0);
 
-    return left;
-}
+            if (match(Token::QUESTION)) {
+                frames.push_back({TERN_THEN, PLUS_OP, 0, operands.back().start, nullptr});
+                break;
+            }
 
-Exp* Parser::parseF() {
-    if (match(Token::NUM)) {
-        return new NumberExp(stoi(previous->text));
-    } else if (match(Token::FLOAT_NUM)) {
-        return new FloatExp(stof(previous->text));
-    } else if (match(Token::STRING)) {
-        return new StringExp(previous->text);
-    } else if (match(Token::TRUE)) {
-        return new BoolExp(true);
-    } else if (match(Token::FALSE)) {
-        return new BoolExp(false);
-    } else if (match(Token::ID)) {
-        string id = previous->text;
-        if (match(Token::LPAREN)) {
-            FcallExp* fcall = new FcallExp(id);
+            // Cualquier otro token cierra la expresion del tope: se completan
+            // los ternarios que ya tienen su rama else
+            while (!frames.empty() && frames.back().kind == TERN_ELSE) {
+                Operand elseExp = operands.back();
+                operands.pop_back();
+                Operand thenExp = operands.back();
+                operands.pop_back();
+                Operand& cond = operands.back();
+                cond.exp = at(frames.back().start, new TernaryExp(cond.exp, thenExp.exp, elseExp.exp));
+                frames.pop_back();
+            }
 
-            if (!check(Token::RPAREN)) {
-                do {
-                    fcall->args.push_back(parseCE());
-                } while (match(Token::COMA));
+            if (frames.empty()) {
+                return operands.back().exp;
             }
 
-            match(Token::RPAREN);
-            return fcall;
-        } else {
-            return new IdExp(id);
+            Frame& top = frames.back();
+            if (top.kind == TERN_THEN) {
+                // El ':' es opcional; sin el la rama else empieza aqui
+                match(Token::COLON);
+                top.kind = TERN_ELSE;
+                break;
+            } else if (top.kind == PAREN) {
+                match(Token::RPAREN);
+                operands.back().start = top.start;
+                frames.pop_back();
+            } else { // CALL
+                top.call->args.push_back(operands.back().exp);
+                operands.pop_back();
+                if (match(Token::COMA)) {
+                    break; // siguiente argumento
+                }
+                match(Token::RPAREN);
+                operands.push_back({top.call, top.start});
+                frames.pop_back();
+            }
         }
-    } else if (match(Token::LPAREN)) {
-        Exp* exp = parseCE();
-        match(Token::RPAREN);
-        return exp;
     }
-
-    return new NumberExp(0);
 }
\ No newline at end of file
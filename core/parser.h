@@ -3,29 +3,88 @@
 
 #include "scanner.h"
 #include "ast.h"
+#include "threadpool.h"
 
 
 class Parser {
 private:
-    Scanner* scanner;
-    Token *current, *previous;
+    const vector<Token>& tokens; // terminado en END
+    Arena& arena;                // dueno de los nodos del AST
+    size_t pos;
+    const Token* current;
+    const Token* previous;
     bool match(Token::Type ttype);
     bool check(Token::Type ttype);
     bool advance();
     bool isAtEnd();
+    const Token& peek(size_t k) const; // lookahead de k tokens (0 = current)
+    string_view lexeme();              // texto de previous (tabla de simbolos o arena)
+
+    // Registra en el nodo el offset de su primer token
+    template <typename T>
+    T* at(uint32_t pos, T* node) {
+        if (node) node->pos = pos;
+        return node;
+    }
+    
+    // Pilas del parser de expresiones (parseCE)
+    enum FrameKind { BINARY, PAREN, CALL, TERN_THEN, TERN_ELSE };
+    struct ExpFrame {
+        FrameKind kind;
+        BinaryOp op;
+        int prec;
+        uint32_t start;
+        FcallExp* call;
+    };
+    struct ExpOperand {
+        Exp* exp;
+        uint32_t start;
+    };
+    vector<ExpFrame> expFrames;
+    vector<ExpOperand> expOperands;
+
+    // Pila de cuerpos abiertos (parseBody): parseStm deja el cuerpo de cada
+    // if/while/for en la pila en lugar de parsearlo, asi que el anidamiento
+    // de bloques tampoco usa la pila nativa
+    enum StmFrameKind { BLOCK, THEN, ELSE, LOOP };
+    struct StmFrame {
+        StmFrameKind kind;
+        Stm* stm;   // THEN/ELSE/LOOP: el statement que espera el cuerpo
+        Body* body; // BLOCK: el cuerpo que se esta llenando
+    };
+    vector<StmFrame> stmFrames;
+    Body* openBody();
     
+    // Modo de pre-pasada de parseParallel: las funciones se saltan contando
+    // llaves y quedan anotadas para parsearlas despues
+    struct DeferredFun {
+        size_t first;  // indice del primer token (el tipo de retorno)
+        size_t last;   // indice del token siguiente a la '}' de cierre
+        FunDec** slot; // lugar reservado en Program::fundecs
+    };
+    vector<DeferredFun>* deferred = nullptr;
+    bool skipFunctionBody();
+    void seek(size_t index);
+
+    friend Program* parseParallel(const vector<Token>& tokens, Arena& arena, ThreadPool& pool);
+    friend class IncrementalParser;
+    friend class StreamingParser;
+
     bool isTypeStart();
     bool isLocalDecl();
     bool isStatement();
     void parseGlobalDecl(Program* prog); 
+    void parseTopLevel(Program* prog);
 
 public:
-    Parser(Scanner* sc);
+    Parser(const vector<Token>& tokens, Arena& arena);
     ~Parser();
     
     Program* parseProgram();
+    FunDec* parseFunctionAt(size_t index); // definicion de funcion que empieza en tokens[index]
+    size_t position() const { return pos; }
     FunDec* parseFunDec();
-    FunDec* parseFunDec(TypeDecl* rtype, string name);
+    FunDec* parseFunDec(TypeDecl* rtype, string_view name, SymbolId sym);
     Body* parseBody();
     VarDec* parseVarDec();
     StructDec* parseStructDec();
@@ -39,13 +98,49 @@ public:
     Stm* parseReturnStm();
     Stm* parsePrintStm();
     
-    // Métodos para expresiones
-    Exp* parseRelExp();
+    // Expresiones: precedencia de operadores, iterativo (ver parser.cpp)
     Exp* parseCE();
-    Exp* parseBE();
-    Exp* parseE();
-    Exp* parseT();
-    Exp* parseF();
+};
+
+// Parsing paralelo: una pre-pasada serial parsea globales y structs y ubica
+// cada funcion por conteo de llaves; los cuerpos se parsean en el pool, por
+// lotes contiguos con un arena propio cada uno, y quedan en Program::fundecs
+// en orden de fuente. El resultado es el mismo que Parser(...).parseProgram();
+// si alguna funcion no termina donde dice el conteo de llaves se vuelve a
+// parsear todo en serie.
+Program* parseParallel(const vector<Token>& tokens, Arena& arena, ThreadPool& pool);
+
+// Parsing por declaraciones sobre un Scanner en modo streaming: solo se
+// guardan los tokens de la declaracion en curso (y a lo sumo hasta el
+// siguiente ';' o '}' de nivel superior). Cada next() parsea una declaracion
+// en un Program nuevo dentro de arena; el llamador lo consume y puede vaciar
+// el arena antes de pedir la siguiente.
+class StreamingParser {
+private:
+    Scanner& scanner;
+    Arena& arena;
+    vector<Token> buf;  // tokens leidos y aun no consumidos, sin el END
+    bool done = false;  // el scanner ya devolvio END
+    uint64_t errorPos = UINT64_MAX;
+    string errorText;
+
+    void fill(size_t minSize);
+
+public:
+    StreamingParser(Scanner& scanner, Arena& arena) : scanner(scanner), arena(arena) { }
+
+    Program* next(); // nullptr al final del archivo
+
+    // Pasada previa sobre un archivo que se puede releer: solo los
+    // encabezados 'tipo nombre (' del nivel superior, sin parsear cuerpos.
+    // f recibe el tipo de retorno (en arena, vale hasta la proxima llamada)
+    // y el nombre de cada funcion.
+    static void functionHeaders(Scanner& scanner, Arena& arena,
+                                const function<void(TypeDecl*, SymbolId)>& f);
+
+    // Primer token ERR: offset absoluto (UINT64_MAX si no hubo) y su texto
+    uint64_t errorOffset() const { return errorPos; }
+    const string& errorLexeme() const { return errorText; }
 };
 
 #endif // PARSER_H
\ No newline at end of file
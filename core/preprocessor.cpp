@@ -0,0 +1,438 @@
+#include "preprocessor.h"
+#include "scanner.h"
+#include <climits>
+#include <cstdlib>
+
+using namespace std;
+
+// Mas anidamiento que esto es casi seguro un include recursivo sin guard
+static const size_t MAX_INCLUDE_DEPTH = 200;
+
+static bool isIdentChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+}
+
+static string_view skipSpaces(string_view s) {
+    size_t i = 0;
+    while (i < s.size() && (s[i] == ' ' || s[i] == '\t')) i++;
+    return s.substr(i);
+}
+
+// "#  ifndef FOO" -> word = "ifndef", rest = "FOO"
+static void splitDirective(string_view text, string_view& word, string_view& rest) {
+    string_view s = skipSpaces(text.substr(1));
+    size_t n = 0;
+    while (n < s.size() && isIdentChar(s[n])) n++;
+    word = s.substr(0, n);
+    rest = skipSpaces(s.substr(n));
+}
+
+static string_view firstWord(string_view s) {
+    size_t n = 0;
+    while (n < s.size() && isIdentChar(s[n])) n++;
+    return s.substr(0, n);
+}
+
+static string dirName(const string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == string::npos) return ".";
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+// Include guard: las dos primeras directivas son #ifndef G y #define G y el
+// #endif que cierra ese #ifndef es lo ultimo del archivo, sin #else
+static SymbolId detectGuard(const vector<Token>& toks) {
+    if (toks.size() < 4 || toks[0].type != Token::PREPROCESSOR || toks[1].type != Token::PREPROCESSOR) {
+        return NO_SYMBOL;
+    }
+    string_view word, rest, word2, rest2;
+    splitDirective(toks[0].text, word, rest);
+    splitDirective(toks[1].text, word2, rest2);
+    string_view guard = firstWord(rest);
+    if (word != "ifndef" || word2 != "define" || guard.empty() || firstWord(rest2) != guard) {
+        return NO_SYMBOL;
+    }
+
+    int depth = 0;
+    for (size_t i = 0; i + 1 < toks.size(); i++) {
+        if (toks[i].type != Token::PREPROCESSOR) continue;
+        splitDirective(toks[i].text, word, rest);
+        if (word == "if" || word == "ifdef" || word == "ifndef") {
+            depth++;
+        } else if (word == "else" || word == "elif") {
+            if (depth == 1) return NO_SYMBOL;
+        } else if (word == "endif") {
+            if (--depth == 0) {
+                return i + 2 == toks.size() ? SymbolTable::global().intern(guard) : NO_SYMBOL;
+            }
+        }
+    }
+    return NO_SYMBOL;
+}
+
+const Header* HeaderCache::load(const string& path) {
+    char resolved[PATH_MAX];
+    string key = realpath(path.c_str(), resolved) ? string(resolved) : path;
+    auto it = headers.find(key);
+    if (it != headers.end()) {
+        return it->second.get();
+    }
+
+    unique_ptr<Header> header(new Header());
+    if (!header->text.open(key)) {
+        return nullptr;
+    }
+    header->path = key;
+    header->tokens = Scanner(header->text.view()).scanAll();
+    header->guard = detectGuard(header->tokens);
+    for (const Token& tok : header->tokens) {
+        string_view word, rest;
+        if (tok.type != Token::PREPROCESSOR) continue;
+        splitDirective(tok.text, word, rest);
+        if (word == "pragma" && firstWord(rest) == "once") {
+            header->once = true;
+        }
+    }
+    lexed++;
+    return (headers[key] = move(header)).get();
+}
+
+HeaderCache& HeaderCache::global() {
+    static HeaderCache cache;
+    return cache;
+}
+
+Preprocessor::Preprocessor(const string& fileName, HeaderCache& cache)
+    : cache(cache), mainDir(dirName(fileName)) { }
+
+bool Preprocessor::systemInclude(const Token& tok) {
+    string_view word, rest;
+    splitDirective(tok.text, word, rest);
+    return word == "include" && (rest.empty() || rest[0] == '<');
+}
+
+vector<Token> Preprocessor::run(vector<Token> tokens) {
+    bool needed = false;
+    for (const Token& tok : tokens) {
+        if (tok.type == Token::PREPROCESSOR || (tok.type == Token::INCLUDE && !systemInclude(tok))) {
+            needed = true;
+            break;
+        }
+    }
+    if (!needed) {
+        return tokens;
+    }
+
+    files.push_back({&tokens, 0, nullptr, mainDir, 0});
+
+    vector<Token> out;
+    out.reserve(tokens.size());
+    Token tok;
+    while (next(tok)) {
+        if (tok.type == Token::ID && !macros.empty() && expand(tok)) {
+            continue;
+        }
+        out.push_back(tok);
+    }
+    out.push_back(tokens.back());
+    return out;
+}
+
+void Preprocessor::error(string message) {
+    diags.push_back({mainPos, move(message)});
+}
+
+// Siguiente token ya sin directivas ni grupos inactivos: primero lo pendiente
+// de las expansiones, despues el archivo de arriba de la pila
+bool Preprocessor::next(Token& tok) {
+    while (true) {
+        if (expansions.size() > floor) {
+            Expansion& e = expansions.back();
+            if (e.next < e.tokens.size()) {
+                tok = e.tokens[e.next++];
+                return true;
+            }
+            expansions.pop_back();
+            continue;
+        }
+        if (files.empty()) {
+            return false;
+        }
+
+        File& f = files.back();
+        const Token& t = (*f.tokens)[f.next];
+        if (t.type == Token::END) {
+            endFile();
+            continue;
+        }
+        f.next++;
+        if (!f.header) {
+            mainPos = t.pos; // dentro de un header queda en su #include
+        }
+        if (!active() && t.type != Token::PREPROCESSOR) {
+            continue;
+        }
+        if (t.type == Token::PREPROCESSOR || (t.type == Token::INCLUDE && !systemInclude(t))) {
+            directive(t);
+            continue;
+        }
+
+        tok = t;
+        if (f.header) {
+            if (t.type == Token::ERR) {
+                LineTable::Location loc = LineTable(f.header->text.view()).locate(t.pos);
+                error("caracter invalido '" + string(t.text) + "' en " + f.header->path + ":" +
+                      to_string(loc.line) + ":" + to_string(loc.column));
+            }
+            tok.pos = mainPos;
+        }
+        return true;
+    }
+}
+
+void Preprocessor::pushBack(const Token& tok) {
+    expansions.push_back({{tok}, 0, NO_SYMBOL});
+}
+
+bool Preprocessor::disabled(SymbolId sym) const {
+    for (const Expansion& e : expansions) {
+        if (e.macro == sym) return true;
+    }
+    return false;
+}
+
+// Si name es una macro activa deja su expansion pendiente de leer
+bool Preprocessor::expand(const Token& name) {
+    auto it = macros.find(name.sym);
+    if (it == macros.end() || disabled(name.sym)) {
+        return false;
+    }
+    const Macro& macro = it->second;
+
+    vector<vector<Token>> args;
+    if (macro.function) {
+        // Sin '(' a continuacion el nombre queda como identificador comun
+        Token tok;
+        if (!next(tok)) {
+            return false;
+        }
+        if (tok.type != Token::LPAREN) {
+            pushBack(tok);
+            return false;
+        }
+
+        args.emplace_back();
+        int depth = 0;
+        while (true) {
+            if (!next(tok)) {
+                error("falta ')' en la invocacion de " + string(name.text));
+                break;
+            }
+            if (tok.type == Token::LPAREN) {
+                depth++;
+            } else if (tok.type == Token::RPAREN) {
+                if (depth == 0) break;
+                depth--;
+            } else if (tok.type == Token::COMA && depth == 0) {
+                args.emplace_back();
+                continue;
+            }
+            args.back().push_back(tok);
+        }
+        if (macro.params.empty() && args.size() == 1 && args[0].empty()) {
+            args.clear();
+        }
+        if (args.size() != macro.params.size()) {
+            error("la macro " + string(name.text) + " espera " + to_string(macro.params.size()) +
+                  " argumentos y recibio " + to_string(args.size()));
+            return true;
+        }
+        // Los argumentos se expanden completos antes de sustituirlos
+        for (vector<Token>& arg : args) {
+            arg = expandList(move(arg));
+        }
+    }
+
+    Expansion e{{}, 0, name.sym};
+    for (const Token& tok : macro.body) {
+        size_t k = 0;
+        if (tok.type == Token::ID) {
+            while (k < macro.params.size() && macro.params[k] != tok.sym) k++;
+        } else {
+            k = macro.params.size();
+        }
+        if (k < macro.params.size()) {
+            e.tokens.insert(e.tokens.end(), args[k].begin(), args[k].end());
+        } else {
+            e.tokens.push_back(tok);
+        }
+    }
+    for (Token& tok : e.tokens) {
+        tok.pos = name.pos;
+    }
+    counts.expansions++;
+    expansions.push_back(move(e));
+    return true;
+}
+
+// Expande una lista de tokens sola: ni el archivo ni las expansiones de
+// afuera se leen, pero las macros que se estan expandiendo siguen desactivadas
+vector<Token> Preprocessor::expandList(vector<Token> toks) {
+    vector<File> outer;
+    swap(outer, files);
+    size_t outerFloor = floor;
+    floor = expansions.size();
+    expansions.push_back({move(toks), 0, NO_SYMBOL});
+
+    vector<Token> out;
+    Token tok;
+    while (next(tok)) {
+        if (tok.type == Token::ID && expand(tok)) {
+            continue;
+        }
+        out.push_back(tok);
+    }
+
+    floor = outerFloor;
+    swap(outer, files);
+    return out;
+}
+
+void Preprocessor::directive(const Token& tok) {
+    string_view word, rest;
+    splitDirective(tok.text, word, rest);
+
+    // Los condicionales se siguen aun dentro de un grupo inactivo
+    if (word == "ifdef" || word == "ifndef") {
+        SymbolId sym = SymbolTable::global().find(firstWord(rest));
+        bool value = (sym != NO_SYMBOL && macros.count(sym)) == (word == "ifdef");
+        bool parent = active();
+        conds.push_back({parent && value, !parent || value, false});
+        return;
+    }
+    if (word == "if" || word == "elif") {
+        // Sin evaluador de expresiones: el grupo se descarta
+        if (active()) {
+            error("directiva no soportada: #" + string(word));
+        }
+        if (word == "if") {
+            conds.push_back({false, true, false});
+        } else if (conds.size() > files.back().conds) {
+            conds.back().active = false;
+        }
+        return;
+    }
+    if (word == "else") {
+        if (conds.size() <= files.back().conds || conds.back().sawElse) {
+            error("#else sin #ifdef");
+            return;
+        }
+        Cond& c = conds.back();
+        c.sawElse = true;
+        c.active = !c.taken;
+        c.taken = true;
+        return;
+    }
+    if (word == "endif") {
+        if (conds.size() <= files.back().conds) {
+            error("#endif sin #ifdef");
+            return;
+        }
+        conds.pop_back();
+        return;
+    }
+
+    if (!active()) {
+        return;
+    }
+    if (word == "define") {
+        define(rest);
+    } else if (word == "undef") {
+        SymbolId sym = SymbolTable::global().find(firstWord(rest));
+        if (sym != NO_SYMBOL) macros.erase(sym);
+    } else if (word == "include") {
+        include(rest);
+    } else if (word == "pragma") {
+        // #pragma once ya lo anoto la cache; el resto se ignora
+    } else {
+        error("directiva no soportada: #" + string(word));
+    }
+}
+
+void Preprocessor::define(string_view rest) {
+    string_view name = firstWord(rest);
+    if (name.empty()) {
+        error("#define sin nombre");
+        return;
+    }
+
+    Macro macro;
+    string_view body = rest.substr(name.size());
+    // Es de funcion solo si el '(' va pegado al nombre
+    if (!body.empty() && body[0] == '(') {
+        size_t close = body.find(')');
+        if (close == string_view::npos) {
+            error("falta ')' en los parametros de " + string(name));
+            return;
+        }
+        macro.function = true;
+        for (const Token& p : Scanner(body.substr(1, close - 1)).scanAll()) {
+            if (p.type == Token::ID) {
+                macro.params.push_back(p.sym);
+            }
+        }
+        body = body.substr(close + 1);
+    }
+    for (const Token& t : Scanner(body).scanAll()) {
+        // las '\' de continuacion de linea no son parte del cuerpo
+        if (t.type == Token::END || (t.type == Token::ERR && t.text == "\\")) continue;
+        macro.body.push_back(t);
+    }
+    macros[SymbolTable::global().intern(name)] = move(macro);
+}
+
+void Preprocessor::include(string_view rest) {
+    size_t close = rest.size() > 0 && rest[0] == '"' ? rest.find('"', 1) : string_view::npos;
+    if (close == string_view::npos) {
+        error("#include mal formado");
+        return;
+    }
+    string name(rest.substr(1, close - 1));
+    if (files.size() > MAX_INCLUDE_DEPTH) {
+        error("demasiados #include anidados en \"" + name + "\"");
+        return;
+    }
+
+    // Primero junto al archivo que incluye, despues los -I
+    const Header* header = nullptr;
+    if (!name.empty() && name[0] == '/') {
+        header = cache.load(name);
+    } else {
+        header = cache.load(files.back().dir + "/" + name);
+        for (size_t i = 0; !header && i < includeDirs.size(); i++) {
+            header = cache.load(includeDirs[i] + "/" + name);
+        }
+    }
+    if (!header) {
+        error("no se encontro el header \"" + name + "\"");
+        return;
+    }
+
+    counts.includes++;
+    if ((header->once && included.count(header)) ||
+        (header->guard != NO_SYMBOL && macros.count(header->guard))) {
+        counts.skipped++;
+        return;
+    }
+    included.insert(header);
+    files.push_back({&header->tokens, 0, header, dirName(header->path), conds.size()});
+}
+
+void Preprocessor::endFile() {
+    if (conds.size() > files.back().conds) {
+        error(files.back().header ? "falta #endif en " + files.back().header->path : "falta #endif");
+        conds.resize(files.back().conds);
+    }
+    files.pop_back();
+}
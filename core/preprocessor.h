@@ -0,0 +1,125 @@
+#ifndef PREPROCESSOR_H
+#define PREPROCESSOR_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include "token.h"
+#include "source.h"
+
+using namespace std;
+
+// Header local ya escaneado; sus tokens apuntan a text, que vive mientras
+// viva la cache
+struct Header {
+    string path;                // canonico (realpath), clave de la cache
+    SourceBuffer text;
+    vector<Token> tokens;       // terminado en END, pos relativos al header
+    SymbolId guard = NO_SYMBOL; // #ifndef G / #define G ... #endif cubre todo el archivo
+    bool once = false;          // tiene #pragma once
+};
+
+// Headers del proceso: cada archivo se lee y se escanea una sola vez, por
+// mas que lo incluyan muchos fuentes o muchas veces el mismo
+class HeaderCache {
+private:
+    unordered_map<string, unique_ptr<Header>> headers;
+    size_t lexed = 0;
+
+public:
+    const Header* load(const string& path); // nullptr si no se puede abrir
+    size_t lexedCount() const { return lexed; }
+
+    static HeaderCache& global();
+};
+
+// Preprocesador sobre tokens: #include "..." de headers locales, #define de
+// objeto y de funcion, #undef, #ifdef/#ifndef/#else/#endif y #pragma once.
+// Del resultado salen todas las directivas salvo los #include <...> del
+// sistema, que quedan como INCLUDE y el parser los salta. Los tokens que vienen de un header o de una macro llevan el pos
+// del #include o de la invocacion en el archivo principal, asi los
+// diagnosticos y --source-map siguen apuntando al fuente que se compila.
+class Preprocessor {
+public:
+    struct Diagnostic {
+        uint32_t pos; // en el archivo principal
+        string message;
+    };
+
+    struct Stats {
+        size_t includes = 0;   // #include "..." procesados
+        size_t skipped = 0;    // de esos, saltados por include guard o #pragma once
+        size_t expansions = 0; // macros expandidas
+    };
+
+    vector<string> includeDirs; // -I, despues del directorio del que incluye
+
+    explicit Preprocessor(const string& fileName, HeaderCache& cache = HeaderCache::global());
+
+    // tokens terminados en END; sin directivas que procesar vuelven tal cual
+    vector<Token> run(vector<Token> tokens);
+
+    const vector<Diagnostic>& diagnostics() const { return diags; }
+    const Stats& stats() const { return counts; }
+
+private:
+    struct Macro {
+        bool function = false;
+        vector<SymbolId> params;
+        vector<Token> body;
+    };
+
+    // Archivo en lectura: el principal abajo, los headers incluidos encima
+    struct File {
+        const vector<Token>* tokens;
+        size_t next;
+        const Header* header; // nullptr en el archivo principal
+        string dir;           // para resolver sus #include
+        size_t conds;         // conds.size() al entrar
+    };
+
+    // Tokens de una expansion pendientes de releer; macro queda desactivada
+    // (no se vuelve a expandir) hasta que se consumen
+    struct Expansion {
+        vector<Token> tokens;
+        size_t next;
+        SymbolId macro;
+    };
+
+    struct Cond {
+        bool active;  // el grupo actual se compila
+        bool taken;   // ya hubo una rama activa (o el padre esta inactivo)
+        bool sawElse;
+    };
+
+    HeaderCache& cache;
+    string mainDir;
+    unordered_map<SymbolId, Macro> macros;
+    unordered_set<const Header*> included;
+    vector<File> files;
+    vector<Expansion> expansions;
+    size_t floor = 0; // expansiones por debajo no se leen (argumentos)
+    vector<Cond> conds;
+    uint32_t mainPos = 0; // ultimo token leido del archivo principal
+    Stats counts;
+    vector<Diagnostic> diags;
+
+    bool next(Token& tok);
+    static bool systemInclude(const Token& tok);
+    void pushBack(const Token& tok);
+    bool expand(const Token& name);
+    vector<Token> expandList(vector<Token> toks);
+    bool disabled(SymbolId sym) const;
+    bool active() const { return conds.empty() || conds.back().active; }
+
+    void directive(const Token& tok);
+    void define(string_view rest);
+    void include(string_view rest);
+    void endFile();
+    void error(string message);
+};
+
+#endif // PREPROCESSOR_H
@@ -0,0 +1,607 @@
+#include "range.h"
+#include <algorithm>
+
+using namespace std;
+
+static const Interval ANY;
+static const Interval NONE = {1, 0};
+
+static Interval point(long long v) {
+    return {v, v};
+}
+
+static Interval join(Interval a, Interval b) {
+    if (a.empty()) return b;
+    if (b.empty()) return a;
+    return {min(a.lo, b.lo), max(a.hi, b.hi)};
+}
+
+static bool contains(Interval outer, Interval inner) {
+    return inner.empty() || (inner.lo >= outer.lo && inner.hi <= outer.hi);
+}
+
+static bool full(Interval a) {
+    return a.lo == LLONG_MIN && a.hi == LLONG_MAX;
+}
+
+// El extremo que sigue creciendo se va al limite
+static Interval widen(Interval head, Interval next) {
+    if (head.empty()) return next;
+    return {next.lo < head.lo ? LLONG_MIN : head.lo, next.hi > head.hi ? LLONG_MAX : head.hi};
+}
+
+// Si puede salir de 64 bits el registro da la vuelta: cualquier valor
+static Interval fit(__int128 lo, __int128 hi) {
+    if (lo < LLONG_MIN || hi > LLONG_MAX) return ANY;
+    return {(long long)lo, (long long)hi};
+}
+
+// Con el divisor de un solo signo los extremos salen de las esquinas
+static Interval quotient(Interval l, Interval r) {
+    __int128 a = (__int128)l.lo / r.lo, b = (__int128)l.lo / r.hi;
+    __int128 c = (__int128)l.hi / r.lo, d = (__int128)l.hi / r.hi;
+    return fit(min(min(a, b), min(c, d)), max(max(a, b), max(c, d)));
+}
+
+static Interval arith(BinaryOp op, Interval l, Interval r) {
+    if (l.empty() || r.empty()) return NONE;
+    switch (op) {
+    case PLUS_OP:
+        return fit((__int128)l.lo + r.lo, (__int128)l.hi + r.hi);
+    case MINUS_OP:
+        return fit((__int128)l.lo - r.hi, (__int128)l.hi - r.lo);
+    case MUL_OP: {
+        __int128 a = (__int128)l.lo * r.lo, b = (__int128)l.lo * r.hi;
+        __int128 c = (__int128)l.hi * r.lo, d = (__int128)l.hi * r.hi;
+        return fit(min(min(a, b), min(c, d)), max(max(a, b), max(c, d)));
+    }
+    case DIV_OP: {
+        // dividir por 0 no da resultado: el programa termina ahi
+        Interval result = NONE;
+        if (r.lo < 0) result = join(result, quotient(l, {r.lo, min(r.hi, -1LL)}));
+        if (r.hi > 0) result = join(result, quotient(l, {max(r.lo, 1LL), r.hi}));
+        return result;
+    }
+    default:
+        return ANY;
+    }
+}
+
+// 1 o 0 si los rangos deciden la comparacion, -1 si no
+static int compare(BinaryOp op, Interval l, Interval r) {
+    bool same = l.lo == l.hi && r.lo == r.hi && l.lo == r.lo;
+    bool disjoint = l.hi < r.lo || l.lo > r.hi;
+    switch (op) {
+        case LT_OP: return l.hi < r.lo ? 1 : l.lo >= r.hi ? 0 : -1;
+        case LE_OP: return l.hi <= r.lo ? 1 : l.lo > r.hi ? 0 : -1;
+        case GT_OP: return l.lo > r.hi ? 1 : l.hi <= r.lo ? 0 : -1;
+        case GE_OP: return l.lo >= r.hi ? 1 : l.hi < r.lo ? 0 : -1;
+        case EQ_OP: return same ? 1 : disjoint ? 0 : -1;
+        case NE_OP: return disjoint ? 1 : same ? 0 : -1;
+        default: return -1;
+    }
+}
+
+static BinaryOp opposite(BinaryOp op) {
+    switch (op) {
+        case LT_OP: return GE_OP;
+        case LE_OP: return GT_OP;
+        case GT_OP: return LE_OP;
+        case GE_OP: return LT_OP;
+        case EQ_OP: return NE_OP;
+        default: return EQ_OP;
+    }
+}
+
+// x op y  <=>  y mirror(op) x
+static BinaryOp mirror(BinaryOp op) {
+    switch (op) {
+        case LT_OP: return GT_OP;
+        case LE_OP: return GE_OP;
+        case GT_OP: return LT_OP;
+        case GE_OP: return LE_OP;
+        default: return op;
+    }
+}
+
+static bool isComparison(BinaryOp op) {
+    return op == LT_OP || op == LE_OP || op == GT_OP || op == GE_OP || op == EQ_OP || op == NE_OP;
+}
+
+// x < y solo dice lo mismo de los intervalos si la comparacion es con signo
+static bool signedInt(Exp* e) {
+    return e->type == INT_VALUE || e->type == BOOL_VALUE;
+}
+
+// ====== Estado ======
+
+Interval RangeAnalysis::get(int var) const {
+    if (!havoc.empty() && var < havoc.back().vars && stamps[var] < havoc.back().time) {
+        return ANY;
+    }
+    return values[var];
+}
+
+void RangeAnalysis::set(int var, Interval range) {
+    trail.push_back({var, values[var], stamps[var]});
+    values[var] = range;
+    stamps[var] = ++clock;
+}
+
+int RangeAnalysis::declare(SymbolId sym) {
+    int var = values.size();
+    values.push_back(ANY);
+    stamps.push_back(++clock);
+    scope.add_var(sym, var);
+    if (where.size() < values.size()) {
+        where.resize(values.size(), -1);
+    }
+    return var;
+}
+
+void RangeAnalysis::undo(size_t mark) {
+    while (trail.size() > mark) {
+        const Undo& u = trail.back();
+        values[u.var] = u.old;
+        stamps[u.var] = u.oldStamp;
+        trail.pop_back();
+    }
+}
+
+// Valor actual de cada local < vars escrita desde mark
+RangeAnalysis::Changes RangeAnalysis::changes(size_t mark, int vars) {
+    Changes out;
+    for (size_t i = mark; i < trail.size(); i++) {
+        int v = trail[i].var;
+        if (v < vars && where[v] < 0) {
+            where[v] = out.size();
+            out.push_back({v, get(v)});
+        }
+    }
+    for (auto& c : out) {
+        where[c.first] = -1;
+    }
+    return out;
+}
+
+// Junta dos ramas: lo que una no escribio vale lo de antes
+void RangeAnalysis::merge(const Changes& a, const Changes& b) {
+    for (size_t i = 0; i < b.size(); i++) {
+        where[b[i].first] = i;
+    }
+    for (auto& c : a) {
+        int i = where[c.first];
+        set(c.first, join(c.second, i >= 0 ? b[i].second : get(c.first)));
+        if (i >= 0) where[c.first] = -2;
+    }
+    for (auto& c : b) {
+        if (where[c.first] != -2) {
+            set(c.first, join(get(c.first), c.second));
+        }
+        where[c.first] = -1;
+    }
+}
+
+// Las locales del bloque mueren: se sacan del trail y de cada una de afuera
+// queda solo la entrada mas vieja, asi el trail no crece con el anidamiento
+void RangeAnalysis::closeBody(size_t mark, int vars) {
+    size_t kept = mark;
+    for (size_t i = mark; i < trail.size(); i++) {
+        int v = trail[i].var;
+        if (v < vars && where[v] < 0) {
+            where[v] = 0;
+            trail[kept++] = trail[i];
+        }
+    }
+    for (size_t i = mark; i < kept; i++) {
+        where[trail[i].var] = -1;
+    }
+    trail.resize(kept);
+    values.resize(vars);
+    stamps.resize(vars);
+}
+
+RangeAnalysis::Value RangeAnalysis::pop() {
+    Value v = stack.back();
+    stack.pop_back();
+    return v;
+}
+
+// ====== Condiciones ======
+
+Interval RangeAnalysis::rangeOf(Exp* e) {
+    if (NumberExp* n = e->as<NumberExp>()) return point(n->value);
+    if (BoolExp* b = e->as<BoolExp>()) return point(b->value ? 1 : 0);
+    if (IdExp* id = e->as<IdExp>()) {
+        const int* v = scope.find(id->sym);
+        if (v && id->type != FLOAT_VALUE) return get(*v);
+    }
+    return ANY;
+}
+
+void RangeAnalysis::bound(int var, BinaryOp op, Interval r) {
+    if (r.empty() || full(r)) return;
+    Interval cur = get(var), n = cur;
+    switch (op) {
+    case LT_OP:
+        if (r.hi == LLONG_MIN) n = NONE; else n.hi = min(n.hi, r.hi - 1);
+        break;
+    case LE_OP:
+        n.hi = min(n.hi, r.hi);
+        break;
+    case GT_OP:
+        if (r.lo == LLONG_MAX) n = NONE; else n.lo = max(n.lo, r.lo + 1);
+        break;
+    case GE_OP:
+        n.lo = max(n.lo, r.lo);
+        break;
+    case EQ_OP:
+        n.lo = max(n.lo, r.lo);
+        n.hi = min(n.hi, r.hi);
+        break;
+    case NE_OP:
+        if (r.lo != r.hi) break;
+        if (n.lo == r.lo) {
+            if (r.lo == LLONG_MAX) n = NONE; else n.lo = r.lo + 1;
+        } else if (n.hi == r.lo) {
+            n.hi = r.lo - 1;
+        }
+        break;
+    default:
+        break;
+    }
+    if (n.lo != cur.lo || n.hi != cur.hi) {
+        set(var, n);
+    }
+}
+
+// Lo que se sabe de las locales cuando cond dio truth: x op y con x o y
+// variable, o una variable sola (distinta de 0)
+void RangeAnalysis::refine(Exp* cond, bool truth) {
+    if (IdExp* id = cond->as<IdExp>()) {
+        const int* v = scope.find(id->sym);
+        if (v && id->type != FLOAT_VALUE) bound(*v, truth ? NE_OP : EQ_OP, point(0));
+        return;
+    }
+    BinaryExp* b = cond->as<BinaryExp>();
+    if (!b || !isComparison(b->op) || !signedInt(b->left) || !signedInt(b->right)) return;
+    BinaryOp op = truth ? b->op : opposite(b->op);
+    if (IdExp* l = b->left->as<IdExp>()) {
+        if (const int* v = scope.find(l->sym)) bound(*v, op, rangeOf(b->right));
+    }
+    if (IdExp* r = b->right->as<IdExp>()) {
+        if (const int* v = scope.find(r->sym)) bound(*v, mirror(op), rangeOf(b->left));
+    }
+}
+
+// ====== Recorrido ======
+
+RangeAnalysis::Stats RangeAnalysis::run(FunDec* fd) {
+    scope.clear();
+    scope.add_level();
+    values.clear();
+    stamps.clear();
+    trail.clear();
+    havoc.clear();
+    stack.clear();
+    seen.clear();
+    loopDepth = 0;
+    for (SymbolId sym : fd->psyms) {
+        declare(sym);
+    }
+    if (fd->body) {
+        walk(fd->body);
+    }
+
+    Stats stats;
+    for (BinaryExp* e : seen) {
+        if (e->left->type == FLOAT_VALUE || e->right->type == FLOAT_VALUE) continue;
+        if (isComparison(e->op)) {
+            stats.comparisons++;
+            if (e->facts & (BinaryExp::ALWAYS_TRUE | BinaryExp::ALWAYS_FALSE)) stats.resolved++;
+            continue;
+        }
+        stats.intOps++;
+        if (e->facts & BinaryExp::FITS_32) stats.narrowed++;
+        if (e->op == DIV_OP) {
+            stats.divisions++;
+            if (e->facts & BinaryExp::NON_NEGATIVE) stats.unsignedDivs++;
+        }
+    }
+    return stats;
+}
+
+void RangeAnalysis::binary(BinaryExp* exp) {
+    Value r = pop(), l = pop();
+    Value result = {ANY, l.pure && r.pure};
+    if (l.range.empty() || r.range.empty()) {
+        stack.push_back({NONE, result.pure}); // no se alcanza
+        return;
+    }
+
+    uint8_t facts = BinaryExp::ANALYZED;
+    bool integer = exp->left->type != FLOAT_VALUE && exp->right->type != FLOAT_VALUE;
+    bool isUnsigned = exp->left->type == UNSIGNED_VALUE || exp->right->type == UNSIGNED_VALUE;
+    bool nonNegative = l.range.lo >= 0 && r.range.lo >= 0;
+    if (!integer) {
+        // float: no se sigue
+    } else if (isComparison(exp->op)) {
+        result.range = {0, 1};
+        // sin signo solo si con signo da lo mismo
+        int known = isUnsigned && !nonNegative ? -1 : compare(exp->op, l.range, r.range);
+        if (known >= 0) {
+            result.range = point(known);
+            if (result.pure) facts |= known ? BinaryExp::ALWAYS_TRUE : BinaryExp::ALWAYS_FALSE;
+        }
+    } else {
+        result.range = arith(exp->op, l.range, r.range);
+        if (exp->op == DIV_OP) {
+            if (r.range.lo <= 0 && r.range.hi >= 0) result.pure = false;
+            if (isUnsigned && !nonNegative) result.range = ANY; // divq
+            if (nonNegative) facts |= BinaryExp::NON_NEGATIVE;
+            if (l.range.within(0, UINT32_MAX) && r.range.within(0, UINT32_MAX)) facts |= BinaryExp::FITS_32;
+        } else if (!result.range.empty() && result.range.within(0, UINT32_MAX)) {
+            facts |= BinaryExp::FITS_32;
+        }
+    }
+
+    if (!(exp->facts & BinaryExp::ANALYZED)) {
+        exp->facts = facts;
+        seen.push_back(exp);
+    } else {
+        exp->facts &= facts;
+    }
+    stack.push_back(result);
+}
+
+int RangeAnalysis::visit(BinaryExp* exp) {
+    then(exp->left);
+    then(exp->right);
+    then([=] { binary(exp); });
+    return 0;
+}
+
+int RangeAnalysis::visit(NumberExp* exp) {
+    stack.push_back({point(exp->value), true});
+    return 0;
+}
+
+int RangeAnalysis::visit(BoolExp* exp) {
+    stack.push_back({point(exp->value ? 1 : 0), true});
+    return 0;
+}
+
+int RangeAnalysis::visit(FloatExp* exp) {
+    stack.push_back({ANY, true});
+    return 0;
+}
+
+int RangeAnalysis::visit(StringExp* exp) {
+    stack.push_back({ANY, true});
+    return 0;
+}
+
+int RangeAnalysis::visit(IdExp* exp) {
+    stack.push_back({rangeOf(exp), true});
+    return 0;
+}
+
+int RangeAnalysis::visit(FcallExp* exp) {
+    for (auto arg : exp->args) {
+        then(arg);
+    }
+    then([=] {
+        stack.resize(stack.size() - exp->args.size());
+        stack.push_back({ANY, false});
+    });
+    return 0;
+}
+
+int RangeAnalysis::visit(TernaryExp* exp) {
+    then(exp->condition);
+    then(exp->thenExp);
+    then(exp->elseExp);
+    then([=] {
+        Value e = pop(), t = pop(), c = pop();
+        Interval range = exp->type == FLOAT_VALUE ? ANY : join(t.range, e.range);
+        stack.push_back({range, c.pure && t.pure && e.pure});
+    });
+    return 0;
+}
+
+// Lo que queda en una local al asignarle un valor de tipo source
+void RangeAnalysis::store(SymbolId sym, ValueType target, ValueType source, Interval range) {
+    const int* v = scope.find(sym);
+    if (!v) return; // global
+    set(*v, target == FLOAT_VALUE || source == FLOAT_VALUE ? ANY : range);
+}
+
+// Como el codegen: la variable se liga antes de evaluar su inicializador
+int RangeAnalysis::visit(VarDec* vd) {
+    ValueType t = TypeCheckerVisitor::valueType(vd->type);
+    for (auto& var : vd->vars) {
+        VarDec::VarInit* v = &var;
+        then([=] {
+            declare(v->sym);
+            if (v->init_value) {
+                then(v->init_value);
+                then([=] { store(v->sym, t, v->init_value->type, pop().range); });
+            } else {
+                store(v->sym, t, INT_VALUE, point(0)); // el codegen la pone en 0
+            }
+        });
+    }
+    return 0;
+}
+
+int RangeAnalysis::visit(AssignStm* stm) {
+    then(stm->rhs);
+    then([=] { store(stm->sym, stm->target, stm->rhs->type, pop().range); });
+    return 0;
+}
+
+int RangeAnalysis::visit(PrintStm* stm) {
+    for (auto arg : stm->args) {
+        then(arg);
+        then([=] { pop(); });
+    }
+    return 0;
+}
+
+int RangeAnalysis::visit(ReturnStm* stm) {
+    if (stm->expr) {
+        then(stm->expr);
+        then([=] { pop(); });
+    }
+    return 0;
+}
+
+int RangeAnalysis::visit(FcallStm* stm) {
+    if (stm->fcall) {
+        then(stm->fcall);
+        then([=] { pop(); });
+    }
+    return 0;
+}
+
+int RangeAnalysis::visit(Body* body) {
+    scope.add_level();
+    size_t mark = trail.size();
+    int vars = values.size();
+    for (auto vd : body->vardecs) {
+        then(vd);
+    }
+    for (auto stm : body->stmts) {
+        then(stm);
+    }
+    then([=] {
+        scope.remove_level();
+        closeBody(mark, vars);
+    });
+    return 0;
+}
+
+// Cada rama con lo que dice la condicion; despues se juntan
+int RangeAnalysis::visit(IfStm* stm) {
+    then(stm->condition);
+    then([=] {
+        pop();
+        size_t mark = trail.size();
+        int vars = values.size();
+        refine(stm->condition, true);
+        if (stm->thenbody) then(stm->thenbody);
+        then([=] {
+            Changes a = changes(mark, vars);
+            undo(mark);
+            refine(stm->condition, false);
+            if (stm->elsebody) then(stm->elsebody);
+            then([=] {
+                Changes b = changes(mark, vars);
+                undo(mark);
+                merge(a, b);
+            });
+        });
+    });
+    return 0;
+}
+
+int RangeAnalysis::visit(WhileStm* stm) {
+    loop(stm->condition, stm->body, nullptr);
+    return 0;
+}
+
+int RangeAnalysis::visit(ForStm* stm) {
+    if (stm->init) then(stm->init);
+    then([=] { loop(stm->condition, stm->body, stm->update); });
+    return 0;
+}
+
+void RangeAnalysis::loop(Exp* cond, Body* body, AssignStm* update) {
+    size_t mark = trail.size();
+    int vars = values.size();
+    loopDepth++;
+    if (loopDepth <= LOOP_DEPTH) {
+        iterate(cond, body, update, mark, vars, 0, Changes());
+        return;
+    }
+
+    // Una sola pasada: adentro las locales de afuera valen cualquier cosa
+    // hasta que se escriben, y a la salida las que se escribieron tambien
+    havoc.push_back({vars, ++clock});
+    if (cond) then(cond);
+    then([=] {
+        if (cond) {
+            pop();
+            refine(cond, true);
+        }
+        if (body) then(body);
+        if (update) then(update);
+        then([=] {
+            Changes written = changes(mark, vars);
+            havoc.pop_back();
+            undo(mark);
+            for (auto& c : written) {
+                set(c.first, ANY);
+            }
+            if (cond) refine(cond, false);
+            loopDepth--;
+        });
+    });
+}
+
+// Una vuelta con el estado de la cabeza ya puesto (head: lo que difiere de
+// la entrada). Si lo que llega al final cabe en la cabeza, la salida es la
+// cabeza con la condicion falsa; si no, se ensancha y se vuelve a recorrer.
+// La segunda vez que no cabe va al intervalo completo: a lo sumo tres vueltas.
+void RangeAnalysis::iterate(Exp* cond, Body* body, AssignStm* update, size_t mark, int vars, int round, Changes head) {
+    if (cond) then(cond);
+    then([=] {
+        if (cond) {
+            pop();
+            refine(cond, true);
+        }
+        if (body) then(body);
+        if (update) then(update);
+        then([=] {
+            Changes out = changes(mark, vars);
+            undo(mark);
+            for (size_t i = 0; i < head.size(); i++) {
+                where[head[i].first] = i;
+            }
+            Changes next;
+            bool stable = true;
+            for (auto& c : out) {
+                int i = where[c.first];
+                Interval entry = get(c.first);
+                Interval h = i >= 0 ? head[i].second : entry;
+                Interval n = join(entry, c.second);
+                if (!contains(h, n)) {
+                    stable = false;
+                    next.push_back({c.first, round == 0 ? widen(h, n) : ANY});
+                } else if (i >= 0) {
+                    next.push_back({c.first, h});
+                }
+            }
+            for (auto& c : head) {
+                where[c.first] = -1;
+            }
+
+            if (stable) {
+                for (auto& c : head) {
+                    set(c.first, c.second);
+                }
+                if (cond) refine(cond, false);
+                loopDepth--;
+                return;
+            }
+            for (auto& c : next) {
+                set(c.first, c.second);
+            }
+            iterate(cond, body, update, mark, vars, round + 1, next);
+        });
+    });
+}
+
+int RangeAnalysis::visit(FunDec* fd)     { return 0; }
+int RangeAnalysis::visit(StructDec* sd)  { return 0; }
+int RangeAnalysis::visit(Program* prog)  { return 0; }
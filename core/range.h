@@ -0,0 +1,112 @@
+#ifndef RANGE_H
+#define RANGE_H
+
+#include <climits>
+#include "visitor.h"
+
+using namespace std;
+
+// Intervalo de valores de 64 bits con signo, como quedan en el registro.
+// Vacio (lo > hi): el punto no se alcanza.
+struct Interval {
+    long long lo = LLONG_MIN;
+    long long hi = LLONG_MAX;
+
+    bool empty() const { return lo > hi; }
+    bool within(long long a, long long b) const { return lo >= a && hi <= b; }
+};
+
+// Analisis de rangos por intervalos sobre las locales enteras de una funcion
+// y sus expresiones. Corre despues del Canonicalizer y anota en cada
+// BinaryExp entera los BinaryExp::Fact que valen en todas sus evaluaciones:
+// el codegen usa operaciones de 32 bits, divide sin signo y resuelve
+// comparaciones. Las globales, los parametros, los float y lo que devuelve
+// una llamada valen cualquier cosa.
+// - los if se recorren con la condicion como hecho en cada rama y se juntan
+// - los bucles iteran hasta un punto fijo, ensanchando a los extremos lo que
+//   sigue creciendo; con mas de LOOP_DEPTH bucles anidados se hace una sola
+//   pasada en la que las locales de afuera valen cualquier cosa hasta que se
+//   escriben
+// - un desborde posible de 64 bits da el intervalo completo
+class RangeAnalysis : public WalkingVisitor {
+public:
+    struct Stats {
+        int intOps = 0;        // + - * / enteros
+        int narrowed = 0;      // en 32 bits
+        int divisions = 0;
+        int unsignedDivs = 0;  // / con operandos >= 0
+        int comparisons = 0;
+        int resolved = 0;      // comparaciones resueltas
+    };
+    Stats run(FunDec* fd);
+
+    static const int LOOP_DEPTH = 2;
+
+private:
+    struct Value {
+        Interval range;
+        bool pure; // sin llamadas ni divisiones que puedan fallar
+    };
+    struct Undo {
+        int var;
+        Interval old;
+        uint32_t oldStamp;
+    };
+    struct Havoc {
+        int vars;      // las locales < vars ...
+        uint32_t time; // ... que no se escribieron desde time valen cualquier cosa
+    };
+    typedef vector<pair<int, Interval>> Changes;
+
+    Environment<int> scope;   // SymbolId -> indice en values
+    vector<Interval> values;  // por local visible
+    vector<uint32_t> stamps;  // cuando se escribio cada local
+    vector<Undo> trail;       // para volver a un estado anterior
+    vector<Havoc> havoc;
+    vector<Value> stack;      // valores de las expresiones recorridas
+    vector<BinaryExp*> seen;
+    vector<int> where;        // auxiliar de merge, por local
+    uint32_t clock = 0;
+    int loopDepth = 0;
+
+    Interval get(int var) const;
+    void set(int var, Interval range);
+    int declare(SymbolId sym);
+    void undo(size_t mark);
+    Changes changes(size_t mark, int vars);
+    void merge(const Changes& a, const Changes& b);
+    void closeBody(size_t mark, int vars);
+    Value pop();
+
+    Interval rangeOf(Exp* e);
+    void refine(Exp* cond, bool truth);
+    void bound(int var, BinaryOp op, Interval r);
+    void binary(BinaryExp* exp);
+    void loop(Exp* cond, Body* body, AssignStm* update);
+    void iterate(Exp* cond, Body* body, AssignStm* update, size_t mark, int vars, int round, Changes head);
+    void store(SymbolId sym, ValueType target, ValueType source, Interval range);
+
+public:
+    int visit(BinaryExp* exp) override;
+    int visit(NumberExp* exp) override;
+    int visit(FloatExp* exp) override;
+    int visit(IdExp* exp) override;
+    int visit(BoolExp* exp) override;
+    int visit(StringExp* exp) override;
+    int visit(FcallExp* exp) override;
+    int visit(VarDec* vd) override;
+    int visit(StructDec* sd) override;
+    int visit(FunDec* fd) override;
+    int visit(AssignStm* stm) override;
+    int visit(PrintStm* stm) override;
+    int visit(IfStm* stm) override;
+    int visit(WhileStm* stm) override;
+    int visit(ForStm* stm) override;
+    int visit(ReturnStm* stm) override;
+    int visit(FcallStm* stm) override;
+    int visit(Body* body) override;
+    int visit(Program* prog) override;
+    int visit(TernaryExp* exp) override;
+};
+
+#endif // RANGE_H
@@ -3,10 +3,10 @@ import subprocess
 import shutil
 
 # Archivos c++
-programa = ["main.cpp", "scanner.cpp", "token.cpp", "parser.cpp", "ast.cpp", "visitor.cpp"]
+programa = ["main.cpp", "scanner.cpp", "token.cpp", "parser.cpp", "ast.cpp", "visitor.cpp", "charclass.cpp", "source.cpp", "threadpool.cpp", "arena.cpp", "flatast.cpp", "symbols.cpp", "incremental.cpp", "astcache.cpp", "preprocessor.cpp", "canonicalizer.cpp", "range.cpp"]
 
 # Compilar
-compile = ["g++"] + programa
+compile = ["g++", "-pthread"] + programa
 print("Compilando:", " ".join(compile))
 result = subprocess.run(compile, capture_output=True, text=True)
 
@@ -21,7 +21,7 @@ input_dir = "inputs"
 output_dir = "outputs"
 os.makedirs(output_dir, exist_ok=True)
 
-for i in range(1, 19):
+for i in range(1, 21):
     filename = f"input{i}.txt"
     filepath = os.path.join(input_dir, filename)
 
@@ -43,3 +43,58 @@ for i in range(1, 19):
 
     else:
         print(filename, "no encontrado en", input_dir)
+
+# Anidamiento profundo: sin recursion por nivel en ningun modo
+print("Ejecutando deep_inputs.py")
+result = subprocess.run(["python3", "deep_inputs.py"])
+if result.returncode != 0:
+    exit(1)
+
+# Scanner por bloques: cada tamano de bloque de 1 a 4096 contra scanAll()
+chunks = ["g++", "-pthread", "-O1", "-o", "scanner_chunks", "scanner_chunks.cpp", "scanner.cpp",
+          "token.cpp", "charclass.cpp", "symbols.cpp", "arena.cpp", "threadpool.cpp"]
+print("Compilando:", " ".join(chunks))
+result = subprocess.run(chunks, capture_output=True, text=True)
+if result.returncode != 0:
+    print("Error en compilación:\n", result.stderr)
+    exit(1)
+entradas = [os.path.join(input_dir, f"input{i}.txt") for i in range(1, 21)]
+result = subprocess.run(["./scanner_chunks"] + [e for e in entradas if os.path.isfile(e)])
+if result.returncode != 0:
+    exit(1)
+
+# Lexing paralelo: scanParallel y --jobs=N contra el scanner serial
+print("Ejecutando parallel_lex.py")
+result = subprocess.run(["python3", "parallel_lex.py"])
+if result.returncode != 0:
+    exit(1)
+
+# --stream con memoria acotada (stream_rss.py sin --gb genera 4 GB)
+print("Ejecutando stream_rss.py --gb 0.1")
+result = subprocess.run(["python3", "stream_rss.py", "--gb", "0.1"])
+if result.returncode != 0:
+    exit(1)
+
+# --stream-compile contra el camino normal, con llamadas adelantadas
+print("Ejecutando stream_inputs.py")
+result = subprocess.run(["python3", "stream_inputs.py"])
+if result.returncode != 0:
+    exit(1)
+
+# --stream-compile con 100000 funciones: memoria y llamadas adelantadas
+print("Ejecutando stream_compile_rss.py")
+result = subprocess.run(["python3", "stream_compile_rss.py"])
+if result.returncode != 0:
+    exit(1)
+
+# ThreadPool: parallelFor seguidos, con los hilos demorados a proposito
+stress = ["g++", "-pthread", "-O1", "-fsanitize=address", "-DTHREADPOOL_STRESS",
+          "-o", "threadpool_stress", "threadpool_stress.cpp", "threadpool.cpp"]
+print("Compilando:", " ".join(stress))
+result = subprocess.run(stress, capture_output=True, text=True)
+if result.returncode != 0:
+    print("Error en compilación:\n", result.stderr)
+    exit(1)
+result = subprocess.run(["./threadpool_stress"])
+if result.returncode != 0:
+    exit(1)
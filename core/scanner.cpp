@@ -1,147 +1,232 @@
 #include <iostream>
-#include <cstring>
 #include <fstream>
+#include <unistd.h>
+#include <algorithm>
 #include "token.h"
 #include "scanner.h"
+#include "charclass.h"
 
 using namespace std;
 
-Scanner::Scanner(const char* s): input(s), first(0), current(0) { }
+Scanner::Scanner(string_view s, uint64_t origin)
+    : input(s), first(0), current(0), kernels(&bestCharKernels()),
+      symbols(&SymbolTable::global()), fd(-1), chunkSize(0), eof(true), origin(origin) { }
 
-bool is_white_space(char c) {
-    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+Scanner::Scanner(int fd, size_t chunkSize)
+    : input(), first(0), current(0), kernels(&bestCharKernels()),
+      symbols(&SymbolTable::global()), fd(fd), chunkSize(chunkSize), eof(false), origin(0) { }
+
+// Palabras reservadas (incluye los tipos int/float). Se ubican en una tabla
+// de hash perfecto indexada por (primer + 9 * ultimo caracter) & 15, generada
+// en tiempo de compilacion: cada identificador paga un solo compare.
+namespace {
+
+struct Keyword {
+    string_view text;
+    Token::Type type;
+};
+
+constexpr Keyword keywords[] = {
+    {"if", Token::IF},         {"else", Token::ELSE},
+    {"while", Token::WHILE},   {"for", Token::FOR},
+    {"return", Token::RETURN}, {"printf", Token::PRINTF},
+    {"true", Token::TRUE},     {"false", Token::FALSE},
+    {"unsigned", Token::UNSIGNED}, {"struct", Token::STRUCT},
+    {"int", Token::INT},       {"float", Token::FLOAT}
+};
+
+constexpr unsigned keywordHash(char first, char last) {
+    return ((unsigned char)first + 9u * (unsigned char)last) & 15u;
 }
 
-Token* Scanner::nextToken() {
-    Token* token;
-    char c;
-    while (current < input.length() && is_white_space(input[current])) {
-        current++;
+struct KeywordTable {
+    Keyword slots[16];
+    bool perfect;
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table{};
+    table.perfect = true;
+    for (const Keyword& kw : keywords) {
+        Keyword& slot = table.slots[keywordHash(kw.text.front(), kw.text.back())];
+        if (!slot.text.empty()) table.perfect = false;
+        slot = kw;
     }
+    return table;
+}
 
-    if (current >= input.length()) {
-        return new Token(Token::END);
+constexpr KeywordTable keywordTable = buildKeywordTable();
+static_assert(keywordTable.perfect, "colision en la tabla de palabras reservadas");
+
+Token::Type lookupKeyword(string_view lexema) {
+    const Keyword& kw = keywordTable.slots[keywordHash(lexema.front(), lexema.back())];
+    return kw.text == lexema ? kw.type : Token::ID;
+}
+
+}
+
+Token Scanner::nextToken() {
+    while (true) {
+        size_t start = current;
+        Token token = scanToken();
+        // Un token que llega al final de la ventana puede continuar en el
+        // siguiente bloque: se recarga y se vuelve a escanear desde su inicio.
+        if (current < input.length() || eof) {
+            token.pos = (uint32_t)min<uint64_t>(origin + first, UINT32_MAX);
+            if (token.type == Token::ID || token.type == Token::STRING) {
+                token.sym = symbols->intern(token.text);
+            }
+            return token;
+        }
+        current = start;
+        refill(start);
+    }
+}
+
+void Scanner::refill(size_t keepFrom) {
+    string next;
+    next.reserve(input.length() - keepFrom + chunkSize);
+    next.append(input.data() + keepFrom, input.length() - keepFrom);
+
+    size_t target = next.length() + chunkSize;
+    while (next.length() < target) {
+        size_t old = next.length();
+        next.resize(target);
+        ssize_t n = read(fd, &next[old], target - old);
+        if (n <= 0) {
+            next.resize(old);
+            eof = true;
+            break;
+        }
+        next.resize(old + n);
     }
 
+    if (!window.empty()) {
+        retired.push_back(move(window));
+    }
+    window = move(next);
+    input = window;
+    origin += keepFrom;
+    current -= keepFrom;
     first = current;
+}
+
+Token Scanner::scanToken() {
+    Token token;
+    char c;
+    const char* base = input.data();
+    const char* end = base + input.length();
+
+    current = kernels->skipSpaces(base + current, end) - base;
+
+    first = current;
+    if (current >= input.length()) {
+        return Token(Token::END, input, current, 0);
+    }
+
     c = input[current];
 
-    // Manejar directivas de preprocesador (#include, #define, etc.)
+    // Manejar directivas de preprocesador (#include, #define, etc.). Una barra
+    // invertida al final de la linea continua la directiva en la siguiente.
     if (c == '#') {
         current++;
         while (current < input.length() && 
                input[current] != '\n' && input[current] != '\r') {
+            if (input[current] == '\\' && current + 1 < input.length() &&
+                (input[current + 1] == '\n' || input[current + 1] == '\r')) {
+                current += input.compare(current + 1, 2, "\r\n") == 0 ? 3 : 2;
+                continue;
+            }
             current++;
         }
         
-        string directive = input.substr(first, current - first);
+        string_view directive(base + first, current - first);
         
-        if (directive.find("#include") == 0) {
-            return new Token(Token::INCLUDE, input, first, current - first);
+        if (directive.substr(0, 8) == "#include") {
+            return Token(Token::INCLUDE, input, first, current - first);
         } else {
-            return new Token(Token::PREPROCESSOR, input, first, current - first);
+            return Token(Token::PREPROCESSOR, input, first, current - first);
         }
     }
-    else if (isdigit(c)) {
-        while (current < input.length() && isdigit(input[current])) {
-            current++;
-        }
+    else if (hasClass(c, CC_DIGIT)) {
+        current = kernels->skipDigits(base + current, end) - base;
         
         // Verificar si es un número flotante
         if (current < input.length() && input[current] == '.') {
             current++; 
-            if (current < input.length() && isdigit(input[current])) {
-                while (current < input.length() && isdigit(input[current])) {
-                    current++;
-                }
-                token = new Token(Token::FLOAT_NUM, input, first, current - first);
+            if (current < input.length() && hasClass(input[current], CC_DIGIT)) {
+                current = kernels->skipDigits(base + current, end) - base;
+                token = Token(Token::FLOAT_NUM, input, first, current - first);
             } else {
                 // Punto sin dígitos después - error
-                return new Token(Token::ERR, input, first, current - first);
+                return Token(Token::ERR, input, first, current - first);
             }
         } else {
-            token = new Token(Token::NUM, input, first, current - first);
+            token = Token(Token::NUM, input, first, current - first);
         }
     }
     else if (c == '"') {
-        current++;
-        while (current < input.length() && input[current] != '"') {
-            current++;
-        }
+        current = kernels->skipString(base + current + 1, end) - base;
         if (current >= input.length()) {
-            return new Token(Token::ERR, input, first, current - first);
+            return Token(Token::ERR, input, first, current - first);
         }
         current++;
-        token = new Token(Token::STRING, input, first, current - first);
+        token = Token(Token::STRING, input, first, current - first);
     }
 
-    else if (isalpha(c) || c == '_') {
-        while (current < input.length() && (isalnum(input[current]) || input[current] == '_' || input[current] == '.')) {
-            current++;
-        }
-        string lexema = input.substr(first, current - first);
-        
-
-        if (lexema == "if") return new Token(Token::IF, input, first, current - first);
-        else if (lexema == "else") return new Token(Token::ELSE, input, first, current - first);
-        else if (lexema == "while") return new Token(Token::WHILE, input, first, current - first);
-        else if (lexema == "for") return new Token(Token::FOR, input, first, current - first);
-        else if (lexema == "return") return new Token(Token::RETURN, input, first, current - first);
-        else if (lexema == "printf") return new Token(Token::PRINTF, input, first, current - first);
-        else if (lexema == "true") return new Token(Token::TRUE, input, first, current - first);
-        else if (lexema == "false") return new Token(Token::FALSE, input, first, current - first);
-        else if (lexema == "unsigned") return new Token(Token::UNSIGNED, input, first, current - first);
-        else if (lexema == "struct") return new Token(Token::STRUCT, input, first, current - first);
-        else return new Token(Token::ID, input, first, current - first);
+    else if (hasClass(c, CC_ALPHA)) {
+        current = kernels->skipIdent(base + current, end) - base;
+        string_view lexema(base + first, current - first);
+        return Token(lookupKeyword(lexema), input, first, current - first);
     }
     // Otros operadores y símbolos
-    else if (strchr("+/-*(){};,?:=<>", c)) {
+    else if (hasClass(c, CC_OP)) {
         switch (c) {
-            case '+': token = new Token(Token::PLUS, c); break;
-            case '-': token = new Token(Token::MINUS, c); break;
+            case '+': token = Token(Token::PLUS, input, first, 1); break;
+            case '-': token = Token(Token::MINUS, input, first, 1); break;
             case '=': 
             if (current + 1 < input.length() && input[current+1]=='=')
             {
                 current++;
-                token = new Token(Token::EQ, input, first, current + 1 - first);
+                token = Token(Token::EQ, input, first, current + 1 - first);
             }
             else{
-                token = new Token(Token::ASSIGN,   c);
+                token = Token(Token::ASSIGN, input, first, 1);
             }
             break;
-            case '*': token = new Token(Token::MUL, c); break;
+            case '*': token = Token(Token::MUL, input, first, 1); break;
             case '<':
             if (current + 1 < input.length() && input[current + 1] == '=') {
                 current++;
-                token = new Token(Token::LE, input, first, current + 1 - first);
+                token = Token(Token::LE, input, first, current + 1 - first);
             } else {
-                token = new Token(Token::LT, input, first, 1);
+                token = Token(Token::LT, input, first, 1);
             }
             break;
 
         case '>':
             if (current + 1 < input.length() && input[current + 1] == '=') {
                 current++;
-                token = new Token(Token::GE, input, first, current + 1 - first); 
+                token = Token(Token::GE, input, first, current + 1 - first); 
             } else {
-                token = new Token(Token::GT, input, first, 1);
+                token = Token(Token::GT, input, first, 1);
             }
             break;
-            case '/': token = new Token(Token::DIV, c); break;
-            case '(': token = new Token(Token::LPAREN, c); break;
-            case ')': token = new Token(Token::RPAREN, c); break;
-            case '{': token = new Token(Token::LBRACE, c); break;
-            case '}': token = new Token(Token::RBRACE, c); break;
-            case ';': token = new Token(Token::SEMICOL, c); break;
-            case ',': token = new Token(Token::COMA, c); break;
-            case '?': token = new Token(Token::QUESTION, c); break;
-            case ':': token = new Token(Token::COLON, c); break;
-            default: token = new Token(Token::ERR, c); break;
+            case '/': token = Token(Token::DIV, input, first, 1); break;
+            case '(': token = Token(Token::LPAREN, input, first, 1); break;
+            case ')': token = Token(Token::RPAREN, input, first, 1); break;
+            case '{': token = Token(Token::LBRACE, input, first, 1); break;
+            case '}': token = Token(Token::RBRACE, input, first, 1); break;
+            case ';': token = Token(Token::SEMICOL, input, first, 1); break;
+            case ',': token = Token(Token::COMA, input, first, 1); break;
+            case '?': token = Token(Token::QUESTION, input, first, 1); break;
+            case ':': token = Token(Token::COLON, input, first, 1); break;
+            default: token = Token(Token::ERR, input, first, 1); break;
         }
         current++;
     }
     else {
-        token = new Token(Token::ERR, c);
+        token = Token(Token::ERR, input, first, 1);
         current++;
     }
 
@@ -150,47 +235,234 @@ Token* Scanner::nextToken() {
 
 Scanner::~Scanner() { }
 
+vector<Token> Scanner::scanAll() {
+    vector<Token> tokens;
+    tokens.reserve(input.length() / 4 + 1);
+    while (true) {
+        tokens.push_back(nextToken());
+        if (tokens.back().type == Token::END) {
+            return tokens;
+        }
+    }
+}
+
+// Por debajo de este tamano no vale la pena repartir
+static const size_t MIN_PARALLEL_CHUNK = 1 << 16;
 
-int ejecutar_scanner(Scanner* scanner, const string& InputFile) {
-    Token* tok;
+vector<Token> scanParallel(string_view source, ThreadPool& pool, size_t chunks) {
+    if (chunks == 0) {
+        chunks = min<size_t>(pool.size() * 4, source.size() / MIN_PARALLEL_CHUNK);
+    }
+    if (chunks <= 1) {
+        return Scanner(source).scanAll();
+    }
 
-    // Crear nombre para archivo de salida
-    string OutputFileName = InputFile;
-    size_t pos = OutputFileName.find_last_of(".");
-    if (pos != string::npos) {
-        OutputFileName = OutputFileName.substr(0, pos);
+    // Cortes justo despues de un '\n': ningun token salvo un string puede
+    // contener un salto de linea (las directivas # terminan en el salvo que
+    // sigan tras una barra invertida, ahi no se corta), asi que el unico
+    // riesgo es un string de varias lineas, que se corrige al coser.
+    auto continued = [&](size_t nl) {
+        size_t k = (nl > 0 && source[nl - 1] == '\r') ? nl - 1 : nl;
+        return k > 0 && source[k - 1] == '\\';
+    };
+    vector<size_t> cuts = {0};
+    for (size_t i = 1; i < chunks; i++) {
+        size_t nl = source.find('\n', max(source.size() * i / chunks, cuts.back()));
+        while (nl != string_view::npos && continued(nl)) {
+            nl = source.find('\n', nl + 1);
+        }
+        if (nl == string_view::npos) break;
+        if (nl + 1 < source.size() && nl + 1 > cuts.back()) {
+            cuts.push_back(nl + 1);
+        }
     }
-    OutputFileName += "_tokens.txt";
+    cuts.push_back(source.size());
+    size_t nparts = cuts.size() - 1;
 
-    ofstream outFile(OutputFileName);
-    if (!outFile.is_open()) {
-        cerr << "Error: no se pudo abrir el archivo " << OutputFileName << endl;
-        return 0;
+    vector<vector<Token>> parts(nparts);
+    vector<SymbolTable> tables(nparts);
+    pool.parallelFor(nparts, [&](size_t i) {
+        Scanner sc(source.substr(cuts[i], cuts[i + 1] - cuts[i]), cuts[i]);
+        sc.setSymbols(&tables[i]);
+        parts[i] = sc.scanAll();
+        if (i + 1 < nparts) parts[i].pop_back(); // END del bloque
+    });
+
+    auto offsetOf = [&](const Token& t) { return (size_t)(t.text.data() - source.data()); };
+
+    // Ids locales -> globales, internando cada nombre al copiar su primer
+    // token: la tabla global queda en el mismo orden que con un solo scanner
+    // y sin los fragmentos de tokens cortados que se descartan.
+    SymbolTable& global = SymbolTable::global();
+    vector<vector<SymbolId>> remap(nparts);
+    for (size_t p = 0; p < nparts; p++) {
+        remap[p].assign(tables[p].size(), NO_SYMBOL);
     }
+    auto globalize = [&](size_t p, Token t) {
+        if (t.sym != NO_SYMBOL) {
+            SymbolId& g = remap[p][t.sym];
+            if (g == NO_SYMBOL) g = global.intern(tables[p].name(t.sym));
+            t.sym = g;
+        }
+        return t;
+    };
 
-    outFile << "Scanner\n" << endl;
+    size_t total = 0;
+    for (auto& part : parts) total += part.size();
+    vector<Token> tokens;
+    tokens.reserve(total);
 
-    while (true) {
-        tok = scanner->nextToken();
+    size_t i = 0, k = 0;
+    while (i < nparts) {
+        vector<Token>& part = parts[i];
+        // Un token que llega al corte puede seguir en el bloque siguiente
+        for (; k < part.size(); k++) {
+            const Token& t = part[k];
+            if (i + 1 < nparts && offsetOf(t) + t.text.size() == cuts[i + 1]) break;
+            tokens.push_back(globalize(i, t));
+        }
+        if (k == part.size()) {
+            i++;
+            k = 0;
+            continue;
+        }
 
-        if (tok->type == Token::END) {
-            outFile << *tok << endl;
-            delete tok;
-            outFile << "\nScanner exitoso" << endl << endl;
-            outFile.close();
-            return 0;
+        // Re-escaneo serial desde el token cortado hasta que un token empiece
+        // en el mismo offset que uno especulativo posterior al corte: el
+        // scanner no tiene mas estado que la posicion, asi que desde ahi los
+        // bloques vuelven a ser validos.
+        size_t from = offsetOf(part[k]);
+        size_t syncFrom = cuts[i + 1];
+        Scanner serial(source.substr(from), from);
+        while (true) {
+            Token t = serial.nextToken();
+            size_t off = (t.type == Token::END) ? source.size() : offsetOf(t);
+            if (t.type == Token::END) {
+                tokens.push_back(t);
+                return tokens;
+            }
+            if (off >= syncFrom) {
+                while (i < nparts && (parts[i].empty() || offsetOf(parts[i].back()) < off)) {
+                    i++;
+                }
+                if (i < nparts) {
+                    auto it = lower_bound(parts[i].begin(), parts[i].end(), off,
+                        [&](const Token& a, size_t o) { return offsetOf(a) < o; });
+                    if (offsetOf(*it) == off) {
+                        k = it - parts[i].begin();
+                        break;
+                    }
+                }
+            }
+            tokens.push_back(t);
+        }
+    }
+    return tokens;
+}
+
+// Volcado de tokens con buffer propio: nada de flush por linea, se escribe
+// al archivo en bloques de 64 KB.
+class TokenDump {
+private:
+    ofstream outFile;
+    TokenFormat format;
+    string buf;
+    uint64_t lastOffset = 0;
+
+    void putVarint(uint64_t v) {
+        while (v >= 0x80) {
+            buf += (char)(v | 0x80);
+            v >>= 7;
         }
+        buf += (char)v;
+    }
+
+    void flushIfFull() {
+        if (buf.size() >= (1 << 16)) {
+            outFile.write(buf.data(), buf.size());
+            buf.clear();
+        }
+    }
 
-        if (tok->type == Token::ERR) {
-            outFile << *tok << endl;
-            delete tok;
-            outFile << "Caracter invalido" << endl << endl;
-            outFile << "Scanner no exitoso" << endl << endl;
-            outFile.close();
-            return 0;
+public:
+    TokenDump(const string& InputFile, TokenFormat format) : format(format) {
+        string name = InputFile;
+        size_t pos = name.find_last_of(".");
+        if (pos != string::npos) {
+            name = name.substr(0, pos);
         }
+        name += (format == TokenFormat::BINARY) ? "_tokens.bin" : "_tokens.txt";
 
-        outFile << *tok << endl;
-        delete tok;
+        outFile.open(name, ios::binary);
+        if (!outFile.is_open()) {
+            cerr << "Error: no se pudo abrir el archivo " << name << endl;
+            return;
+        }
+        buf.reserve(1 << 17);
+        if (format == TokenFormat::BINARY) {
+            buf.append("TOKB\x01", 5);
+        } else {
+            buf += "Scanner\n\n";
+        }
+    }
+
+    bool ok() const { return outFile.is_open(); }
+
+    // Escribe un token; devuelve true si el volcado termina (END o ERR)
+    bool write(const Token& tok, uint64_t offset) {
+        if (format == TokenFormat::BINARY) {
+            buf += (char)tok.type;
+            putVarint(offset - lastOffset);
+            putVarint(tok.text.size());
+            lastOffset = offset;
+        } else {
+            tok.appendTo(buf);
+            buf += '\n';
+            if (tok.type == Token::END) {
+                buf += "\nScanner exitoso\n\n";
+            } else if (tok.type == Token::ERR) {
+                buf += "Caracter invalido\n\n";
+                buf += "Scanner no exitoso\n\n";
+            }
+        }
+        flushIfFull();
+        return tok.type == Token::END || tok.type == Token::ERR;
+    }
+
+    ~TokenDump() {
+        if (ok()) {
+            outFile.write(buf.data(), buf.size());
+        }
+    }
+};
+
+int ejecutar_scanner(const vector<Token>& tokens, string_view source,
+                     const string& InputFile, TokenFormat format) {
+    if (format == TokenFormat::NONE) return 0;
+
+    TokenDump dump(InputFile, format);
+    if (!dump.ok()) return 0;
+
+    for (const Token& tok : tokens) {
+        if (dump.write(tok, tok.text.data() - source.data())) {
+            break;
+        }
+    }
+    return 0;
+}
+
+int ejecutar_scanner(Scanner* scanner, const string& InputFile, TokenFormat format) {
+    if (format == TokenFormat::NONE) return 0;
+
+    TokenDump dump(InputFile, format);
+    if (!dump.ok()) return 0;
+
+    while (true) {
+        Token tok = scanner->nextToken();
+        if (dump.write(tok, scanner->tokenOffset())) {
+            break;
+        }
+        scanner->release();
     }
+    return 0;
 }
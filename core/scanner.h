@@ -2,23 +2,72 @@
 #define SCANNER_H
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
 #include "token.h"
+#include "charclass.h"
+#include "threadpool.h"
 
 using namespace std;
 
 class Scanner {
 private:
-    string input;
-    int first;
-    int current;
+    string_view input; // no se copia: apunta al SourceBuffer del llamador
+    size_t first;
+    size_t current;
+    const CharKernels* kernels; // SIMD o escalar, segun la CPU
+    SymbolTable* symbols;       // donde se internan ID y STRING
+
+    // Modo streaming: input es una ventana sobre el archivo que empieza en
+    // el offset absoluto origin; los bloques se leen de fd bajo demanda.
+    int fd;
+    size_t chunkSize;
+    bool eof;
+    uint64_t origin;
+    string window;
+    vector<string> retired; // ventanas anteriores aun referenciadas por tokens
+
+    Token scanToken();
+    void refill(size_t keepFrom);
 
 public:
-    Scanner(const char* s);
+    Scanner(string_view s, uint64_t origin = 0); // origin: offset de s[0] en el archivo
+    Scanner(int fd, size_t chunkSize = 1 << 20);
+    void setKernels(const CharKernels& k) { kernels = &k; }
+    void setSymbols(SymbolTable* table) { symbols = table; } // por defecto la global
     ~Scanner();
-    Token* nextToken();
+    Token nextToken();
+    vector<Token> scanAll(); // Una sola pasada, termina en END
+
+    // Offset absoluto (64 bits) del inicio del ultimo token
+    uint64_t tokenOffset() const { return origin + first; }
+
+    // En modo streaming el texto de los tokens anteriores al ultimo devuelto
+    // puede vivir en ventanas ya descartadas; el consumidor llama a release()
+    // cuando ya no los necesita para liberar esa memoria.
+    void release() { retired.clear(); }
 };
 
-// Ejecutar scanner
-int ejecutar_scanner(Scanner* scanner, const string& InputFile);
+// Lexing paralelo de un buffer completo: se corta en '\n', cada bloque se
+// escanea en el pool (con su propia tabla de simbolos) y se cosen los
+// resultados, remapeando los ids a la tabla global. Produce exactamente la misma
+// secuencia que Scanner(source).scanAll(). chunks = 0 elige segun el pool.
+vector<Token> scanParallel(string_view source, ThreadPool& pool, size_t chunks = 0);
+
+// Formato del volcado de tokens:
+//  TEXT   -> <archivo>_tokens.txt, una linea TOKEN(TIPO, "texto") por token
+//  BINARY -> <archivo>_tokens.bin: cabecera "TOKB" + version (1 byte) y por
+//            token: tipo (1 byte, Token::Type), varint con la distancia desde
+//            el inicio del token anterior y varint con la longitud (LEB128)
+// Ambos terminan en el primer END o ERR.
+enum class TokenFormat { NONE, TEXT, BINARY };
+
+// Volcar los tokens ya escaneados (source: buffer al que apuntan)
+int ejecutar_scanner(const vector<Token>& tokens, string_view source,
+                     const string& InputFile, TokenFormat format);
+
+// Volcado en streaming: pide los tokens al scanner uno a uno
+int ejecutar_scanner(Scanner* scanner, const string& InputFile, TokenFormat format);
 
 #endif // SCANNER_H
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Escaneo por bloques contra scanAll(): cada fuente se escanea entero en
+// memoria y despues desde el archivo con Scanner(fd, chunkSize) para cada
+// chunkSize de 1 a 4096. Todo token tiene que coincidir en tipo, texto,
+// simbolo y offset, asi que ningun corte de bloque puede partir un token,
+// perder un caracter ni correr una posicion.
+//
+//   g++ -pthread -O1 -o scanner_chunks scanner_chunks.cpp scanner.cpp token.cpp charclass.cpp symbols.cpp arena.cpp threadpool.cpp
+//   ./scanner_chunks [--max-chunk=N] inputs/input*.txt
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "scanner.h"
+
+using namespace std;
+
+// Casos que los inputs no cubren: tokens mas largos que cualquier bloque,
+// operadores de dos caracteres, directivas continuadas, errores y CRLF
+static vector<pair<string, string>> casosBorde() {
+    vector<pair<string, string>> casos;
+    casos.push_back({"identificador largo", "int " + string(5000, 'a') + " = 1;\n"});
+    casos.push_back({"string largo", "printf(\"" + string(3000, 'x') + "\\n\");\n"});
+    casos.push_back({"numeros", "x = 123456789012345 + 3.25 * 10.0 / 7;\n"});
+    casos.push_back({"operadores", "a<=b>=c==d=e<f>g ? h : i;a<b;c>d;e=f\n"});
+    casos.push_back({"directivas", "#include <stdio.h>\r\n#define X 1 \\\r\n  + 2\n#define Y \\\n 3\nint y;\n"});
+    casos.push_back({"crlf", "int main() {\r\n    return 0;\r\n}\r\n"});
+    casos.push_back({"errores", "int x = 3.;\n@ $ x = 1;\n"});
+    casos.push_back({"string sin cerrar", "int x;\nprintf(\"sin cierre"});
+    casos.push_back({"sin salto final", "return x"});
+    casos.push_back({"vacio", ""});
+    return casos;
+}
+
+static bool comparar(const string& nombre, const string& path, const string& fuente, size_t maxChunk) {
+    vector<Token> esperado = Scanner(fuente).scanAll();
+
+    for (size_t chunk = 1; chunk <= maxChunk; chunk++) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            cerr << nombre << ": no se pudo abrir " << path << endl;
+            return false;
+        }
+        Scanner scanner(fd, chunk);
+        bool ok = true;
+        for (size_t i = 0; ok; i++) {
+            Token tok = scanner.nextToken();
+            const Token& e = esperado[i];
+            if (tok.type != e.type || tok.text != e.text || tok.sym != e.sym ||
+                scanner.tokenOffset() != e.pos) {
+                cerr << nombre << ": chunk " << chunk << ", token " << i << ": " << tok
+                     << " en " << scanner.tokenOffset() << ", se esperaba " << e
+                     << " en " << e.pos << endl;
+                ok = false;
+            }
+            scanner.release();
+            if (e.type == Token::END) break;
+        }
+        close(fd);
+        if (!ok) return false;
+    }
+    cout << nombre << ": " << esperado.size() << " tokens, chunks 1.." << maxChunk << " ok" << endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t maxChunk = 4096;
+    vector<string> archivos;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--max-chunk=", 0) == 0) {
+            maxChunk = max(1, atoi(arg.c_str() + 12));
+        } else {
+            archivos.push_back(arg);
+        }
+    }
+
+    int fallas = 0;
+    for (const string& path : archivos) {
+        ifstream in(path, ios::binary);
+        if (!in) {
+            cerr << "No se pudo abrir " << path << endl;
+            return 1;
+        }
+        stringstream ss;
+        ss << in.rdbuf();
+        fallas += !comparar(path, path, ss.str(), maxChunk);
+    }
+
+    char tmp[] = "/tmp/scanner_chunksXXXXXX";
+    int fd = mkstemp(tmp);
+    if (fd < 0) {
+        cerr << "No se pudo crear un temporal" << endl;
+        return 1;
+    }
+    close(fd);
+    for (auto& [nombre, fuente] : casosBorde()) {
+        ofstream(tmp, ios::binary) << fuente;
+        fallas += !comparar(nombre, tmp, fuente, maxChunk);
+    }
+    unlink(tmp);
+
+    return fallas ? 1 : 0;
+}
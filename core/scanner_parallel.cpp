@@ -0,0 +1,191 @@
+// Lexing paralelo contra el scanner serial. Sin --bench compara token por
+// token (tipo, texto, offset y simbolo) scanParallel() con scanAll() para
+// pools de 1 a --max-jobs hilos y, con cada pool, forzando de 2 a 64 bloques
+// para que los cortes caigan tambien dentro de fuentes chicos. La primera
+// pasada sobre cada fuente revisa ademas que la tabla global quede en orden
+// de primera aparicion. Con --bench mide scanParallel sobre --mb megabytes
+// con 1..--max-jobs hilos (mediana de 5) contra scanAll.
+//
+//   g++ -pthread -O2 -o scanner_parallel scanner_parallel.cpp scanner.cpp token.cpp charclass.cpp symbols.cpp arena.cpp threadpool.cpp
+//   ./scanner_parallel [--max-jobs=N] inputs/input*.txt
+//   ./scanner_parallel --bench [--mb=M] [--max-jobs=N]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "scanner.h"
+
+using namespace std;
+
+// Fuente de ~size bytes con lo que complica los cortes en '\n': strings de
+// varias lineas, directivas continuadas, CRLF, tokens largos y errores
+static string generar(size_t size, bool conBordes) {
+    static const char* const trozos[] = {
+        "int f(int a, int b) {\n    int c = a * 3 + b;\n    if (c >= 10) {\n        c = c - 10;\n    }\n    return c;\n}\n",
+        "float g = 2.5;\nunsigned int h = 42;\n",
+        "while (x <= 100) {\n    x = x + y / 2;\n}\n",
+        "printf(\"%d %f\\n\", a, 1.25);\n",
+        "for (i = 0; i < n; i = i + 1) { s = s == t ? s : t; }\n",
+        "struct punto {\n    int x;\n    int y;\n};\n",
+    };
+    static const char* const bordes[] = {
+        "printf(\"una\nlinea\r\notra\n\");\n",
+        "#define LARGO 1 \\\n  + 2 \\\r\n  + 3\n",
+        "int crlf = 1;\r\nreturn crlf;\r\n",
+        "int x = 3.;\n@ $ y;\n",
+        "\n\n\n\n",
+        "\"\n\"\n",
+    };
+    string out;
+    out.reserve(size + 256);
+    unsigned r = 12345;
+    while (out.size() < size) {
+        r = r * 1103515245 + 12345;
+        unsigned k = (r >> 16) % 16;
+        if (conBordes && k >= 10) {
+            out += bordes[k - 10];
+        } else if (conBordes && k == 9 && (r & 0x700) == 0) {
+            out += "int " + string(4096 + (r >> 20) % 100000, 'v') + ";\n";
+        } else {
+            out += trozos[k % 6];
+        }
+    }
+    return out;
+}
+
+// true si coinciden; si no, imprime la primera diferencia
+static bool iguales(const string& nombre, const vector<Token>& serial, const vector<Token>& paralelo,
+                    const string& donde) {
+    for (size_t i = 0; i < max(serial.size(), paralelo.size()); i++) {
+        if (i >= serial.size() || i >= paralelo.size()) {
+            cerr << nombre << " (" << donde << "): " << paralelo.size() << " tokens, se esperaban "
+                 << serial.size() << endl;
+            return false;
+        }
+        const Token& s = serial[i];
+        const Token& p = paralelo[i];
+        if (s.type != p.type || s.text.data() != p.text.data() || s.text.size() != p.text.size() ||
+            s.pos != p.pos || s.sym != p.sym) {
+            cerr << nombre << " (" << donde << "), token " << i << ": " << p << " en " << p.pos
+                 << ", se esperaba " << s << " en " << s.pos << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// En la primera pasada los nombres nuevos tienen que entrar a la tabla
+// global en orden de primera aparicion, sin fragmentos de tokens cortados
+static bool ordenPrimeraAparicion(const string& nombre, const vector<Token>& tokens, size_t antes) {
+    size_t siguiente = antes;
+    for (const Token& t : tokens) {
+        if (t.sym == NO_SYMBOL || t.sym < antes) continue;
+        if (t.sym > siguiente) {
+            cerr << nombre << ": '" << t.text << "' recibio el id " << t.sym << ", se esperaba "
+                 << siguiente << " o menos" << endl;
+            return false;
+        }
+        if (t.sym == siguiente) siguiente++;
+    }
+    if (SymbolTable::global().size() != siguiente) {
+        cerr << nombre << ": la tabla global tiene " << SymbolTable::global().size() - siguiente
+             << " nombres de mas" << endl;
+        return false;
+    }
+    return true;
+}
+
+static bool comparar(const string& nombre, const string& fuente, unsigned maxJobs) {
+    size_t antes = SymbolTable::global().size();
+    bool ok;
+    {
+        ThreadPool pool(maxJobs);
+        ok = ordenPrimeraAparicion(nombre, scanParallel(fuente, pool, 16), antes);
+    }
+    vector<Token> serial = Scanner(fuente).scanAll();
+
+    for (unsigned jobs = 1; ok && jobs <= maxJobs; jobs++) {
+        ThreadPool pool(jobs);
+        ok = iguales(nombre, serial, scanParallel(fuente, pool), to_string(jobs) + " hilos");
+        for (size_t chunks = 2; ok && chunks <= 64; chunks++) {
+            ok = iguales(nombre, serial, scanParallel(fuente, pool, chunks),
+                         to_string(jobs) + " hilos, " + to_string(chunks) + " bloques");
+        }
+    }
+    if (ok) {
+        cout << nombre << ": " << serial.size() << " tokens, 1.." << maxJobs << " hilos ok" << endl;
+    }
+    return ok;
+}
+
+template <typename F>
+static double mediana(F f) {
+    vector<double> t;
+    for (int i = 0; i < 5; i++) {
+        auto inicio = chrono::steady_clock::now();
+        f();
+        t.push_back(chrono::duration<double>(chrono::steady_clock::now() - inicio).count());
+    }
+    sort(t.begin(), t.end());
+    return t[2];
+}
+
+static void benchmark(size_t mb, unsigned maxJobs) {
+    string fuente = generar(mb << 20, false);
+    size_t tokens = 0;
+    double serial = mediana([&] { tokens = Scanner(fuente).scanAll().size(); });
+    double megas = fuente.size() / double(1 << 20);
+    cout << "Fuente: " << megas << " MB, " << tokens << " tokens, "
+         << thread::hardware_concurrency() << " nucleos" << endl;
+    cout << "serial:   " << serial * 1000 << " ms (" << megas / serial << " MB/s)" << endl;
+    for (unsigned jobs = 1; jobs <= maxJobs; jobs++) {
+        ThreadPool pool(jobs);
+        double t = mediana([&] { scanParallel(fuente, pool); });
+        cout << jobs << " hilos: " << t * 1000 << " ms (" << megas / t << " MB/s, x"
+             << serial / t << ")" << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned maxJobs = max(4u, thread::hardware_concurrency());
+    size_t mb = 64;
+    bool bench = false;
+    vector<string> archivos;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--max-jobs=", 0) == 0) {
+            maxJobs = max(1, atoi(arg.c_str() + 11));
+        } else if (arg.rfind("--mb=", 0) == 0) {
+            mb = max(1, atoi(arg.c_str() + 5));
+        } else if (arg == "--bench") {
+            bench = true;
+        } else {
+            archivos.push_back(arg);
+        }
+    }
+
+    if (bench) {
+        benchmark(mb, maxJobs);
+        return 0;
+    }
+
+    int fallas = 0;
+    for (const string& path : archivos) {
+        ifstream in(path, ios::binary);
+        if (!in) {
+            cerr << "No se pudo abrir " << path << endl;
+            return 1;
+        }
+        stringstream ss;
+        ss << in.rdbuf();
+        fallas += !comparar(path, ss.str(), maxJobs);
+    }
+    // Mas de MIN_PARALLEL_CHUNK por bloque: el reparto sin forzar tambien corta
+    fallas += !comparar("generado (2 MB)", generar(2 << 20, true), maxJobs);
+    return fallas ? 1 : 0;
+}
@@ -0,0 +1,106 @@
+#include "source.h"
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SOURCE_POSIX 1
+#else
+#include <fstream>
+#include <iostream>
+#endif
+
+using namespace std;
+
+LineTable::Location LineTable::locate(uint32_t offset) {
+    if (lineStarts.empty()) {
+        lineStarts.push_back(0);
+        for (size_t i = 0; i < source.size(); i++) {
+            if (source[i] == '\n') {
+                lineStarts.push_back(i + 1);
+            }
+        }
+    }
+    auto it = upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+    int line = it - lineStarts.begin();
+    return { line, (int)(offset - lineStarts[line - 1]) + 1 };
+}
+
+SourceBuffer::SourceBuffer() : data(""), size(0), mapped(false) { }
+
+SourceBuffer::~SourceBuffer() {
+#ifdef SOURCE_POSIX
+    if (mapped) {
+        munmap((void*)data, size);
+    }
+#endif
+}
+
+#ifdef SOURCE_POSIX
+
+bool SourceBuffer::readAll(int fd) {
+    char chunk[1 << 16];
+    while (true) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0) return false;
+        if (n == 0) break;
+        owned.append(chunk, n);
+    }
+    data = owned.data();
+    size = owned.size();
+    return true;
+}
+
+bool SourceBuffer::open(const string& path) {
+    if (path == "-") {
+        return readAll(STDIN_FILENO);
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    bool ok;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            data = (const char*)p;
+            size = st.st_size;
+            mapped = true;
+            ok = true;
+        } else {
+            ok = readAll(fd);
+        }
+    } else {
+        ok = readAll(fd);
+    }
+    close(fd);
+    return ok;
+}
+
+#else
+
+bool SourceBuffer::readAll(int) {
+    owned.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+    data = owned.data();
+    size = owned.size();
+    return true;
+}
+
+bool SourceBuffer::open(const string& path) {
+    if (path == "-") {
+        return readAll(0);
+    }
+
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) return false;
+    owned.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    data = owned.data();
+    size = owned.size();
+    return true;
+}
+
+#endif
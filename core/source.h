@@ -0,0 +1,53 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+// Buffer de solo lectura con el programa fuente. Los archivos regulares se
+// mapean en memoria (mmap) sin copiarlos; pipes, stdin ("-") y sistemas sin
+// mmap se leen completos con read().
+class SourceBuffer {
+private:
+    const char* data;
+    size_t size;
+    bool mapped;
+    string owned; // respaldo cuando no se pudo mapear
+
+    bool readAll(int fd);
+
+public:
+    SourceBuffer();
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    bool open(const string& path);
+    string_view view() const { return string_view(data, size); }
+    bool isMapped() const { return mapped; }
+};
+
+// Traduce offsets del fuente a linea/columna (ambas desde 1). La tabla de
+// inicios de linea se arma recien en la primera consulta, asi compilar sin
+// diagnosticos ni --source-map no paga nada; cada consulta es una busqueda
+// binaria.
+class LineTable {
+private:
+    string_view source;
+    vector<uint32_t> lineStarts;
+
+public:
+    struct Location {
+        int line;
+        int column;
+    };
+
+    LineTable(string_view source) : source(source) { }
+    Location locate(uint32_t offset);
+};
+
+#endif // SOURCE_H
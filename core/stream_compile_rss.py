@@ -0,0 +1,108 @@
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+# --stream-compile con muchas funciones: se genera un programa con
+# --funciones funciones (100000 por defecto) en el que main va primero y
+# llama a funciones que se definen despues, una de ellas float. Se compila
+# por el camino normal y en streaming, se mide el pico de memoria residente
+# de cada uno con wait4 y los dos ejecutables tienen que imprimir lo mismo.
+# El pico en streaming tiene que quedar por debajo del normal.
+#
+#   python3 stream_compile_rss.py [--funciones 100000] [--sin-ejecutar]
+
+
+def programa(funciones):
+    ultima = funciones - 1
+    partes = ["#include <stdio.h>\n\n"]
+    # main antes que todo lo que llama
+    partes.append(
+        "int main() {\n"
+        "    float r;\n"
+        "    int s;\n"
+        f"    r = h{ultima}(3);\n"
+        f"    s = f{ultima - 1}(5) + f{funciones // 2}(7) + f0(9);\n"
+        '    printf("%f\\n", r);\n'
+        '    printf("%d\\n", s);\n'
+        "    return 0;\n"
+        "}\n\n")
+    for n in range(funciones):
+        if n % 10 == 9:
+            partes.append(f"float h{n}(int x) {{\n    return x / 2.0 + {n % 10};\n}}\n\n")
+        else:
+            partes.append(
+                f"int f{n}(int a) {{\n"
+                "    int c;\n"
+                f"    c = a * {n % 7} + 1;\n"
+                "    if (c >= 100) {\n"
+                "        c = c - 100;\n"
+                "    }\n"
+                "    return c;\n"
+                "}\n\n")
+    return "".join(partes)
+
+
+def compilar(compilador, archivo, extra):
+    inicio = time.time()
+    proc = subprocess.Popen([compilador, *extra, archivo], stdout=subprocess.DEVNULL,
+                            stderr=subprocess.PIPE)
+    error = proc.stderr.read().decode()
+    _, estado, uso = os.wait4(proc.pid, 0)
+    return os.waitstatus_to_exitcode(estado), uso.ru_maxrss / 1024, time.time() - inicio, error
+
+
+def main():
+    args = argparse.ArgumentParser()
+    args.add_argument("--funciones", type=int, default=100000)
+    args.add_argument("--sin-ejecutar", action="store_true")
+    opciones = args.parse_args()
+    # la ultima tiene que ser una h (float)
+    funciones = max(10, opciones.funciones // 10 * 10)
+
+    compilador = os.path.abspath("./a.out")
+    fallas = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        fuente = programa(funciones)
+        salidas = {}
+        picos = {}
+        for modo in ["normal", "--stream-compile"]:
+            archivo = os.path.join(tmp, f"funciones_{modo.strip('-').replace('-', '_')}.txt")
+            with open(archivo, "w") as f:
+                f.write(fuente)
+            rc, pico, segundos, error = compilar(compilador, archivo, [] if modo == "normal" else [modo])
+            picos[modo] = pico
+            print(f"{modo}: {funciones} funciones, {len(fuente) / (1 << 20):.1f} MB, "
+                  f"{segundos:.1f} s, pico {pico:.1f} MB")
+            if rc != 0:
+                print(f"{modo}: rc={rc} {error.strip()}")
+                fallas += 1
+                continue
+            if opciones.sin_ejecutar:
+                continue
+            asm = os.path.splitext(archivo)[0] + ".s"
+            binario = os.path.join(tmp, "prog")
+            result = subprocess.run(["gcc", "-no-pie", "-o", binario, asm], capture_output=True, text=True)
+            if result.returncode != 0:
+                print(f"{modo}: gcc: {result.stderr.strip()[:200]}")
+                fallas += 1
+                continue
+            salidas[modo] = subprocess.run([binario], capture_output=True, text=True).stdout
+
+    if len(salidas) == 2:
+        if salidas["normal"] != salidas["--stream-compile"]:
+            print(f"La salida cambia con --stream-compile: {salidas['normal']!r} contra "
+                  f"{salidas['--stream-compile']!r}")
+            fallas += 1
+        else:
+            print(f"Salida: {' '.join(salidas['normal'].split())}")
+    if len(picos) == 2 and picos["--stream-compile"] >= picos["normal"]:
+        print("--stream-compile no usa menos memoria que el camino normal")
+        fallas += 1
+    return 1 if fallas else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
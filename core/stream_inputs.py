@@ -0,0 +1,64 @@
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+# --stream-compile genera cada funcion apenas termina de parsearla. Cada input
+# se compila por el camino normal y en streaming, se arma con gcc y las dos
+# ejecuciones tienen que imprimir lo mismo. input20 llama a funciones que se
+# definen despues (una devuelve float): en streaming su tipo sale de la pasada
+# previa sobre el archivo.
+compilador = os.path.abspath("./a.out")
+fallas = 0
+
+
+def ejecutar(archivo, modo, tmp):
+    asm = os.path.splitext(archivo)[0] + ".s"
+    binario = os.path.join(tmp, "prog")
+    result = subprocess.run([compilador] + modo + [archivo], capture_output=True, text=True)
+    if result.returncode != 0:
+        return None, f"rc={result.returncode} {result.stderr.strip()}"
+    result = subprocess.run(["gcc", "-no-pie", "-o", binario, asm], capture_output=True, text=True)
+    if result.returncode != 0:
+        return None, "gcc: " + result.stderr.strip()
+    result = subprocess.run([binario], capture_output=True, text=True, timeout=10)
+    return result.stdout, None
+
+
+with tempfile.TemporaryDirectory() as tmp:
+    for i in range(1, 21):
+        origen = os.path.join("inputs", f"input{i}.txt")
+        if not os.path.isfile(origen):
+            continue
+        salidas = []
+        for modo in [[], ["--stream-compile"]]:
+            archivo = os.path.join(tmp, f"input{i}.txt")
+            shutil.copy(origen, archivo)
+            salida, error = ejecutar(archivo, modo, tmp)
+            if error:
+                print(f"Stream input{i} ({' '.join(modo) or 'normal'}): {error}")
+                fallas += 1
+            salidas.append(salida)
+
+        if None in salidas:
+            continue
+        if salidas[0] != salidas[1]:
+            print(f"Stream input{i}: la salida cambia con --stream-compile")
+            fallas += 1
+        else:
+            print(f"Stream input{i}: ok")
+
+    # Por un pipe no hay pasada previa: la llamada adelantada a una funcion
+    # que no devuelve int tiene que dar error en vez de un resultado basura
+    with open(os.path.join("inputs", "input20.txt"), "rb") as f:
+        fuente = f.read()
+    result = subprocess.run([compilador, "--stream-compile", "-"], input=fuente,
+                            capture_output=True, cwd=tmp)
+    if result.returncode == 0:
+        print("Stream input20 (pipe): se compilo sin conocer el tipo de 'half'")
+        fallas += 1
+    else:
+        print("Stream input20 (pipe): error esperado")
+
+sys.exit(1 if fallas else 0)
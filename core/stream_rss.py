@@ -0,0 +1,101 @@
+import argparse
+import os
+import resource
+import subprocess
+import sys
+import time
+
+# --stream con un fuente de varios GB: el generador escribe directo al stdin
+# del compilador (no hace falta el espacio en disco) y se mide el pico de
+# memoria residente del proceso con wait4. La memoria tiene que quedar
+# acotada por la ventana del scanner, no por el tamano del fuente, y la
+# cantidad de tokens tiene que ser la esperada.
+#
+#   python3 stream_rss.py [--gb 4] [--limite-mb 64] [--archivo salida.txt]
+#
+# Con --archivo el fuente se escribe a disco y se escanea desde ahi.
+
+BLOQUE = """int f{n}(int a, int b) {{
+    int c = a * {n} + b;
+    if (c >= 10) {{
+        c = c - 10;
+    }}
+    printf("%d\\n", c);
+    return c;
+}}
+"""
+
+# ~1 MB de funciones; los nombres se repiten para que la tabla de simbolos no
+# crezca con el fuente
+def trozo():
+    partes = []
+    total = 0
+    n = 0
+    while total < 1 << 20:
+        parte = BLOQUE.format(n=n % 1000)
+        partes.append(parte)
+        total += len(parte)
+        n += 1
+    return "".join(partes).encode()
+
+
+def contar_tokens(compilador, datos):
+    result = subprocess.run([compilador, "--stream", "-"], input=datos, capture_output=True)
+    for linea in result.stdout.decode().splitlines():
+        if linea.startswith("Tokens: "):
+            return int(linea[8:])
+    raise RuntimeError("sin conteo de tokens: " + result.stdout.decode())
+
+
+def main():
+    args = argparse.ArgumentParser()
+    args.add_argument("--gb", type=float, default=4.0)
+    args.add_argument("--limite-mb", type=float, default=64.0)
+    args.add_argument("--archivo")
+    opciones = args.parse_args()
+
+    compilador = os.path.abspath("./a.out")
+    datos = trozo()
+    repeticiones = max(1, int(opciones.gb * (1 << 30)) // len(datos))
+    # cada trozo termina en '}\n': ningun token cruza de uno al siguiente
+    esperados = contar_tokens(compilador, datos) * repeticiones
+    tamano = len(datos) * repeticiones
+
+    inicio = time.time()
+    if opciones.archivo:
+        with open(opciones.archivo, "wb") as f:
+            for _ in range(repeticiones):
+                f.write(datos)
+        inicio = time.time()
+        proc = subprocess.Popen([compilador, "--stream", opciones.archivo], stdout=subprocess.PIPE)
+    else:
+        proc = subprocess.Popen([compilador, "--stream", "-"], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        for _ in range(repeticiones):
+            proc.stdin.write(datos)
+        proc.stdin.close()
+    salida = proc.stdout.read().decode()
+    _, estado, uso = os.wait4(proc.pid, 0)
+    segundos = time.time() - inicio
+
+    # ru_maxrss en KB en Linux
+    pico_mb = uso.ru_maxrss / 1024
+    tokens = next((int(l[8:]) for l in salida.splitlines() if l.startswith("Tokens: ")), -1)
+    print(f"Fuente: {tamano / (1 << 30):.2f} GB, {tokens} tokens en {segundos:.1f} s "
+          f"({tamano / (1 << 20) / max(segundos, 1e-9):.0f} MB/s)")
+    print(f"Pico de memoria residente: {pico_mb:.1f} MB")
+
+    fallas = 0
+    if os.waitstatus_to_exitcode(estado) != 0:
+        print(f"El compilador termino con {os.waitstatus_to_exitcode(estado)}")
+        fallas += 1
+    if tokens != esperados:
+        print(f"Se esperaban {esperados} tokens")
+        fallas += 1
+    if pico_mb > opciones.limite_mb:
+        print(f"El pico supera {opciones.limite_mb:.0f} MB")
+        fallas += 1
+    return 1 if fallas else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
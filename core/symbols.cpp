@@ -0,0 +1,25 @@
+#include "symbols.h"
+
+using namespace std;
+
+SymbolId SymbolTable::intern(string_view s) {
+    auto it = ids.find(s);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    string_view copy = storage.copy(s);
+    SymbolId id = names.size();
+    names.push_back(copy);
+    ids.emplace(copy, id);
+    return id;
+}
+
+SymbolId SymbolTable::find(string_view s) const {
+    auto it = ids.find(s);
+    return it == ids.end() ? NO_SYMBOL : it->second;
+}
+
+SymbolTable& SymbolTable::global() {
+    static SymbolTable table;
+    return table;
+}
@@ -0,0 +1,36 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include "arena.h"
+
+using namespace std;
+
+// Id denso de un identificador o literal de cadena internado
+typedef uint32_t SymbolId;
+const SymbolId NO_SYMBOL = UINT32_MAX;
+
+// Tabla de internado: cada texto distinto recibe un id consecutivo desde 0,
+// en orden de primera aparicion. Los nombres se copian a un arena propio,
+// asi siguen validos aunque el buffer de origen desaparezca (streaming).
+// No es thread-safe: el lexing paralelo usa tablas locales y las remapea.
+class SymbolTable {
+private:
+    unordered_map<string_view, SymbolId> ids;
+    vector<string_view> names;
+    Arena storage;
+
+public:
+    SymbolId intern(string_view s);
+    SymbolId find(string_view s) const;
+    string_view name(SymbolId id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+    // Tabla del proceso: la llenan el scanner y el parser, la usa el codegen
+    static SymbolTable& global();
+};
+
+#endif // SYMBOLS_H
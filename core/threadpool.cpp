@@ -0,0 +1,88 @@
+#include "threadpool.h"
+
+using namespace std;
+
+// Con -DTHREADPOOL_STRESS los hilos se demoran en los puntos donde se
+// cruzan con parallelFor, para que threadpool_stress.cpp vea las carreras
+#ifdef THREADPOOL_STRESS
+#include <unistd.h>
+static void stressPause() {
+    static thread_local unsigned n = 0;
+    usleep(++n % 5 * 20);
+}
+#else
+static void stressPause() {}
+#endif
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = 1;
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lock(m);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& t : workers) {
+        t.join();
+    }
+}
+
+void ThreadPool::runJob(const function<void(size_t)>* fn, size_t count) {
+    size_t i;
+    while ((i = next.fetch_add(1)) < count) {
+        (*fn)(i);
+    }
+}
+
+void ThreadPool::workerLoop() {
+    unsigned seen = 0;
+    while (true) {
+        const function<void(size_t)>* fn;
+        size_t count;
+        stressPause();
+        {
+            unique_lock<mutex> lock(m);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            // Desperto tarde: ese parallelFor ya volvio y no hay que tomar
+            // su trabajo (next puede ser ya el del siguiente)
+            if (!job) continue;
+            fn = job;
+            count = jobCount;
+            active++;
+        }
+        stressPause();
+        runJob(fn, count);
+        {
+            lock_guard<mutex> lock(m);
+            active--;
+        }
+        done.notify_one();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const function<void(size_t)>& fn) {
+    if (workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; i++) fn(i);
+        return;
+    }
+    {
+        lock_guard<mutex> lock(m);
+        job = &fn;
+        jobCount = count;
+        next = 0;
+        generation++;
+    }
+    wake.notify_all();
+    runJob(&fn, count);
+
+    unique_lock<mutex> lock(m);
+    done.wait(lock, [&] { return active == 0 && next >= jobCount; });
+    job = nullptr;
+}
@@ -0,0 +1,42 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Pool fijo de hilos para trabajo de datos paralelos (lexing y parsing por
+// bloques). El hilo que llama a parallelFor tambien trabaja.
+class ThreadPool {
+private:
+    vector<thread> workers;
+    mutex m;
+    condition_variable wake, done;
+    const function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    atomic<size_t> next{0};
+    size_t active = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    void runJob(const function<void(size_t)>* fn, size_t count);
+    void workerLoop();
+
+public:
+    explicit ThreadPool(unsigned threads = thread::hardware_concurrency());
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return workers.size() + 1; }
+
+    // Ejecuta fn(i) para cada i en [0, count) y espera a que terminen todos
+    void parallelFor(size_t count, const function<void(size_t)>& fn);
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,46 @@
+// Prueba de estres del ThreadPool: muchos parallelFor seguidos, con trabajo
+// serial entre uno y otro como entre scanParallel y parseParallel. Cada
+// indice tiene que correr exactamente una vez por llamada; un hilo que
+// despierta tarde no puede tomar un trabajo ya terminado ni correr el
+// siguiente con la cuenta vieja.
+//
+//   g++ -pthread -O1 -fsanitize=address -DTHREADPOOL_STRESS threadpool_stress.cpp threadpool.cpp
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include "threadpool.h"
+
+using namespace std;
+
+int main(int argc, char* argv[]) {
+    unsigned rounds = argc > 1 ? atoi(argv[1]) : 20000;
+    unsigned long sink = 0;
+
+    for (unsigned threads : {2u, 4u, 8u, 16u}) {
+        ThreadPool pool(threads);
+        for (unsigned r = 0; r < rounds; r++) {
+            // Cuentas que cambian en cada vuelta: un hilo con la cuenta de
+            // la llamada anterior se sale de hits
+            size_t count = 2 + (r * 37) % 256;
+            unique_ptr<atomic<unsigned>[]> hits(new atomic<unsigned>[count]);
+            for (size_t i = 0; i < count; i++) hits[i] = 0;
+
+            pool.parallelFor(count, [&](size_t i) {
+                hits[i]++;
+            });
+
+            for (size_t i = 0; i < count; i++) {
+                if (hits[i] != 1) {
+                    cerr << "threads=" << threads << " vuelta " << r << ": indice " << i
+                         << " corrio " << hits[i] << " veces" << endl;
+                    return 1;
+                }
+            }
+            // Trabajo serial de largo variable entre dos llamadas
+            for (unsigned k = 0; k < (r % 7) * 200; k++) sink += k ^ r;
+        }
+        cout << "threads=" << threads << ": " << rounds << " vueltas ok" << endl;
+    }
+    return sink == 1 ? 2 : 0;
+}
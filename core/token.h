@@ -2,7 +2,10 @@
 #define TOKEN_H
 
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <ostream>
+#include "symbols.h"
 
 using namespace std;
 
@@ -13,16 +16,20 @@ public:
         PLUS, MINUS, MUL, DIV, ASSIGN, LT, LE, GT, GE, EQ, NE,
         NUM, FLOAT_NUM, ID, STRING,
         IF, ELSE, WHILE, FOR, RETURN, PRINTF, TRUE, FALSE,
-        UNSIGNED, STRUCT, QUESTION, COLON, INCLUDE, PREPROCESSOR,
+        UNSIGNED, STRUCT, INT, FLOAT, QUESTION, COLON, INCLUDE, PREPROCESSOR,
         ERR, END
     };
 
     Type type;
-    string text;
+    uint32_t pos;     // Offset del token en el fuente (linea/columna via LineTable)
+    SymbolId sym;     // ID y STRING: id del texto en la tabla de simbolos
+    string_view text; // Vista sobre el buffer fuente, no se copia el lexema
 
-    Token(Type type);
-    Token(Type type, char c);
-    Token(Type type, const string& source, int first, int last);
+    Token(Type type = END);
+    Token(Type type, string_view source, size_t first, size_t len);
+
+    static const char* typeName(Type type);
+    void appendTo(string& out) const; // mismo formato que operator<<
     
     friend ostream& operator<<(ostream& outs, const Token& tok);
     friend ostream& operator<<(ostream& outs, const Token* tok);
@@ -1,214 +1,560 @@
 #include <iostream>
 #include "ast.h"
 #include "visitor.h"
+#include "canonicalizer.h"
+#include "range.h"
 #include <unordered_map>
 #include <algorithm>
+#include <queue>
+#include <sstream>
+#include <iomanip>
+#include <climits>
 
 using namespace std;
 
 int TypeCheckerVisitor::type(Program* program){
     fun_memoria.clear();
+    globalTypes.clear();
+    funTypes.clear();
+    assumedInt.clear();
+    inFunction = false;
+    for (auto vd : program->vardecs) {
+        walk(vd);
+    }
+    // Los tipos de retorno antes que los cuerpos: una llamada puede ir
+    // antes de la definicion
+    for (auto fd : program->fundecs) {
+        funTypes[fd->sym] = valueType(fd->rtype);
+    }
     for (auto i : program->fundecs) {
-        i->accept(this);
+        walk(i);
     }
     return 0;
 }
-    
+
+ValueType TypeCheckerVisitor::valueType(TypeDecl* t) {
+    if (!t) return INT_VALUE;
+    switch (t->kind) {
+        case TypeDecl::FLOAT_TYPE: return FLOAT_VALUE;
+        case TypeDecl::UNSIGNED_TYPE: return UNSIGNED_VALUE;
+        case TypeDecl::STRUCT_TYPE: return STRUCT_VALUE;
+        default: return INT_VALUE;
+    }
+}
+
+ValueType TypeCheckerVisitor::lookup(SymbolId sym) {
+    if (const ValueType* t = locals.find(sym)) {
+        return *t;
+    }
+    auto it = globalTypes.find(sym);
+    return it != globalTypes.end() ? it->second : INT_VALUE;
+}
+
 int TypeCheckerVisitor::visit(FunDec* fd) {
     int parametros = fd->ptypes.size();
     locales = 0;
+    funTypes[fd->sym] = valueType(fd->rtype);
+    inFunction = true;
+    locals.clear();
+    locals.add_level();
+    for (size_t i = 0; i < fd->psyms.size(); i++) {
+        locals.add_var(fd->psyms[i], valueType(i < fd->ptypes.size() ? fd->ptypes[i] : nullptr));
+    }
     if (fd->body) {
-        fd->body->accept(this);
+        then(fd->body);
     }
-    fun_memoria[fd->name] = parametros + locales;
+    then([=] {
+        locals.remove_level();
+        inFunction = false;
+        fun_memoria[fd->sym] = parametros + locales;
+    });
     return 0;
 }
 
 
 int TypeCheckerVisitor::visit(Body* body) {
+    locals.add_level();
     for(auto i:body->vardecs){
-        i->accept(this);
+        then(i);
     }
     for(auto i:body->stmts){
-        i->accept(this);
+        then(i);
     }
+    then([=] { locals.remove_level(); });
     return 0;
 }
 
 int TypeCheckerVisitor::visit(VarDec* vd) {
-    locales += vd->vars.size();
+    ValueType t = valueType(vd->type);
+    for (auto& var : vd->vars) {
+        SymbolId sym = var.sym;
+        then([=] {
+            if (inFunction) {
+                locals.add_var(sym, t);
+            } else {
+                globalTypes[sym] = t;
+            }
+        });
+        if (var.init_value) {
+            then(var.init_value);
+        }
+    }
+    if (inFunction) {
+        locales += vd->vars.size();
+    }
     return 0;
 }
 
 
 int TypeCheckerVisitor::visit(WhileStm* stm) {
-    stm->body->accept(this);
+    then(stm->condition);
+    then(stm->body);
     return 0;
 }
 
+// La condicion no declara nada: a se puede tomar antes de recorrerla
 int TypeCheckerVisitor::visit(IfStm* stm) {
     int a = locales;
-    stm->thenbody->accept(this);
-    int b = locales;
-    if (stm->elsebody) {
-        stm->elsebody->accept(this);
-    }
-    int c = locales;
-    locales = a + max(b-a,c-b);
+    then(stm->condition);
+    then(stm->thenbody);
+    then([=] {
+        int b = locales;
+        if (stm->elsebody) {
+            then(stm->elsebody);
+        }
+        then([=] {
+            int c = locales;
+            locales = a + max(b-a,c-b);
+        });
+    });
     return 0;
 }
 
 int TypeCheckerVisitor::visit(ForStm* stm) {
-    if (stm->init) stm->init->accept(this);
-    if (stm->body) stm->body->accept(this);
+    if (stm->init) then(stm->init);
+    if (stm->condition) then(stm->condition);
+    if (stm->update) then(stm->update);
+    if (stm->body) then(stm->body);
     return 0;
 }
 
 int TypeCheckerVisitor::visit(FcallStm* stm) {
+    if (stm->fcall) then(stm->fcall);
     return 0;
 }
 
+// Float si algun lado es float (las comparaciones dan bool); si no,
+// unsigned si algun lado es unsigned
 int TypeCheckerVisitor::visit(BinaryExp* exp) {
+    then(exp->left);
+    then(exp->right);
+    then([=] { binaryType(exp); });
     return 0;
 }
+
+void TypeCheckerVisitor::binaryType(BinaryExp* exp) {
+    ValueType l = exp->left->type, r = exp->right->type;
+    bool comparison = exp->op == LT_OP || exp->op == LE_OP || exp->op == GT_OP ||
+                      exp->op == GE_OP || exp->op == EQ_OP || exp->op == NE_OP;
+    if (comparison) {
+        exp->type = BOOL_VALUE;
+    } else if (l == FLOAT_VALUE || r == FLOAT_VALUE) {
+        exp->type = FLOAT_VALUE;
+    } else if (l == UNSIGNED_VALUE || r == UNSIGNED_VALUE) {
+        exp->type = UNSIGNED_VALUE;
+    } else {
+        exp->type = INT_VALUE;
+    }
+}
 int TypeCheckerVisitor::visit(NumberExp* exp) {
+    exp->type = INT_VALUE;
     return 0;
 }
 int TypeCheckerVisitor::visit(FloatExp* exp)  { 
+    exp->type = FLOAT_VALUE;
     return 0; 
 }
 int TypeCheckerVisitor::visit(IdExp* exp){
+    exp->type = lookup(exp->sym);
     return 0;
 }
 int TypeCheckerVisitor::visit(BoolExp* exp)   { 
+    exp->type = BOOL_VALUE;
     return 0; 
 }
 int TypeCheckerVisitor::visit(StringExp* exp) { 
+    exp->type = STRING_VALUE;
     return 0; 
 }
 int TypeCheckerVisitor::visit(Program* p) {
-    return 0;
+    return type(p);
 }
 int TypeCheckerVisitor::visit(PrintStm* stm) {
+    for (auto arg : stm->args) {
+        then(arg);
+    }
     return 0;
 }
 int TypeCheckerVisitor::visit(AssignStm* stm) {
+    then(stm->rhs);
+    then([=] { stm->target = lookup(stm->sym); });
     return 0;
 }
+// Funciones externas (printf incluido) devuelven int
 int TypeCheckerVisitor::visit(FcallExp* fcall) {
+    for (auto arg : fcall->args) {
+        then(arg);
+    }
+    then([=] {
+        auto it = funTypes.find(fcall->sym);
+        if (it != funTypes.end()) {
+            fcall->type = it->second;
+        } else {
+            fcall->type = INT_VALUE;
+            assumedInt.insert(fcall->sym);
+        }
+    });
     return 0;
 }
 int TypeCheckerVisitor::visit(StructDec* sd)  { 
     return 0; 
 }
 int TypeCheckerVisitor::visit(ReturnStm* r) {
+    if (r->expr) then(r->expr);
     return 0;
 }
 
 int TypeCheckerVisitor::visit(TernaryExp* exp) {
+    then(exp->condition);
+    then(exp->thenExp);
+    then(exp->elseExp);
+    then([=] { ternaryType(exp); });
     return 0;
 }
 
-int CodeGenerator::generar(Program* prog) {
-    typeChecker.type(prog);
-    fun_memoria = typeChecker.fun_memoria;
-    isFloat = false; 
-    isUnsigned = false; 
-    prog->accept(this);
-    return 0;
+void TypeCheckerVisitor::ternaryType(TernaryExp* exp) {
+    ValueType a = exp->thenExp->type, b = exp->elseExp->type;
+    if (a == FLOAT_VALUE || b == FLOAT_VALUE) {
+        exp->type = FLOAT_VALUE;
+    } else if (a == UNSIGNED_VALUE || b == UNSIGNED_VALUE) {
+        exp->type = UNSIGNED_VALUE;
+    } else if (a == BOOL_VALUE && b == BOOL_VALUE) {
+        exp->type = BOOL_VALUE;
+    } else {
+        exp->type = INT_VALUE;
+    }
 }
 
-bool CodeGenerator::evalConstExpr(Exp* e, int& value) {
-    if (auto num = dynamic_cast<NumberExp*>(e)) {
-        value = num->value;
-        return true;
+// ====== Layout del marco ======
+
+int FrameLayoutVisitor::layout(FunDec* fd) {
+    ranges.clear();
+    loopEnd.clear();
+    loops.clear();
+    scope.clear();
+    scope.add_level();
+    point = 0;
+    for (SymbolId sym : fd->psyms) {
+        declare(sym, nullptr);
     }
-
-    if (auto b = dynamic_cast<BoolExp*>(e)) {
-        value = b->value ? 1 : 0;
-        return true;
+    if (fd->body) {
+        walk(fd->body);
+    }
+    for (Range& r : ranges) {
+        if (r.loop >= 0) r.end = max(r.end, loopEnd[r.loop]);
     }
 
-    if (auto id = dynamic_cast<IdExp*>(e)) {
-        auto it = isConst.find(id->value);
-        if (it != isConst.end() && it->second) {
-            value = constVal[id->value];
-            return true;
+    // Los rangos ya estan ordenados por inicio: cada uno toma el slot libre
+    // mas bajo despues de soltar los que terminaron antes
+    priority_queue<pair<int,int>, vector<pair<int,int>>, greater<pair<int,int>>> active; // (fin, slot)
+    priority_queue<int, vector<int>, greater<int>> freeSlots;
+    int slots = 0;
+    paramSlots.clear();
+    for (Range& r : ranges) {
+        while (!active.empty() && active.top().first < r.start) {
+            freeSlots.push(active.top().second);
+            active.pop();
+        }
+        int slot;
+        if (freeSlots.empty()) {
+            slot = slots++;
+        } else {
+            slot = freeSlots.top();
+            freeSlots.pop();
+        }
+        active.push({r.end, slot});
+        int offset = -8 * (slot + 1);
+        if (r.var) {
+            r.var->slot = offset;
+        } else {
+            paramSlots.push_back(offset);
         }
-        return false;
     }
+    return slots;
+}
 
-    if (auto bin = dynamic_cast<BinaryExp*>(e)) {
-        int lv, rv;
-        if (!evalConstExpr(bin->left, lv))  return false;
-        if (!evalConstExpr(bin->right, rv)) return false;
+void FrameLayoutVisitor::declare(SymbolId sym, VarDec::VarInit* var) {
+    scope.add_var(sym, ranges.size());
+    point++;
+    ranges.push_back({point, point, -1, var});
+}
 
-        switch (bin->op) {
-            case PLUS_OP:  value = lv + rv;  return true;
-            case MINUS_OP: value = lv - rv;  return true;
-            case MUL_OP:   value = lv * rv;  return true;
-            case DIV_OP:
-                if (rv == 0) return false;
-                value = lv / rv;
-                return true;
-            case LT_OP:  value = (lv <  rv) ? 1 : 0; return true;
-            case LE_OP:  value = (lv <= rv) ? 1 : 0; return true;
-            case GT_OP:  value = (lv >  rv) ? 1 : 0; return true;
-            case GE_OP:  value = (lv >= rv) ? 1 : 0; return true;
-            case EQ_OP:  value = (lv == rv) ? 1 : 0; return true;
-            case NE_OP:  value = (lv != rv) ? 1 : 0; return true;
-            default: return false;
-        }
+void FrameLayoutVisitor::use(SymbolId sym) {
+    const int* i = scope.find(sym);
+    if (!i) return; // global
+    Range& r = ranges[*i];
+    r.end = ++point;
+    // el bucle mas externo de los que empezaron despues de la declaracion
+    auto it = upper_bound(loops.begin(), loops.end(), r.start,
+                          [](int start, const OpenLoop& l) { return start < l.start; });
+    if (it != loops.end()) {
+        r.loop = it->id;
     }
+}
 
-    return false;
+void FrameLayoutVisitor::openLoop() {
+    loops.push_back({(int)loopEnd.size(), ++point});
+    loopEnd.push_back(0);
 }
 
+void FrameLayoutVisitor::closeLoop() {
+    loopEnd[loops.back().id] = ++point;
+    loops.pop_back();
+}
 
-bool CodeGenerator::exprIsFloat(Exp* e) {
-    if (dynamic_cast<FloatExp*>(e)) return true;
+// El codegen liga la variable antes de evaluar el inicializador, pero el
+// slot recien se escribe despues: la vida empieza en el store
+int FrameLayoutVisitor::visit(VarDec* vd) {
+    for (auto& var : vd->vars) {
+        VarDec::VarInit* v = &var;
+        then([=] {
+            declare(v->sym, v);
+            if (v->init_value) {
+                size_t i = ranges.size() - 1;
+                then(v->init_value);
+                then([=] { ranges[i].start = ranges[i].end = ++point; });
+            }
+        });
+    }
+    return 0;
+}
 
-    if (auto id = dynamic_cast<IdExp*>(e)) {
-        auto it = varTypes.find(id->value);
-        if (it != varTypes.end()) {
-            return it->second == TypeDecl::FLOAT_TYPE;
-        }
-        return false;
+int FrameLayoutVisitor::visit(Body* body) {
+    scope.add_level();
+    for (auto vd : body->vardecs) {
+        then(vd);
+    }
+    for (auto stm : body->stmts) {
+        then(stm);
+    }
+    then([=] { scope.remove_level(); });
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(IfStm* stm) {
+    then(stm->condition);
+    if (stm->thenbody) then(stm->thenbody);
+    if (stm->elsebody) then(stm->elsebody);
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(WhileStm* stm) {
+    openLoop();
+    then(stm->condition);
+    if (stm->body) then(stm->body);
+    then([=] { closeLoop(); });
+    return 0;
+}
+
+// El init corre una sola vez, antes del bucle
+int FrameLayoutVisitor::visit(ForStm* stm) {
+    if (stm->init) then(stm->init);
+    then([=] { openLoop(); });
+    if (stm->condition) then(stm->condition);
+    if (stm->body) then(stm->body);
+    if (stm->update) then(stm->update);
+    then([=] { closeLoop(); });
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(AssignStm* stm) {
+    then(stm->rhs);
+    then([=] { use(stm->sym); });
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(IdExp* exp) {
+    use(exp->sym);
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(BinaryExp* exp) {
+    then(exp->left);
+    then(exp->right);
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(TernaryExp* exp) {
+    then(exp->condition);
+    then(exp->thenExp);
+    then(exp->elseExp);
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(FcallExp* exp) {
+    for (auto arg : exp->args) {
+        then(arg);
     }
+    return 0;
+}
 
-    if (auto bin = dynamic_cast<BinaryExp*>(e)) {
-        return exprIsFloat(bin->left) || exprIsFloat(bin->right);
+int FrameLayoutVisitor::visit(PrintStm* stm) {
+    for (auto arg : stm->args) {
+        then(arg);
     }
+    return 0;
+}
 
-    if (auto tern = dynamic_cast<TernaryExp*>(e)) {
-        return exprIsFloat(tern->thenExp) || exprIsFloat(tern->elseExp);
+int FrameLayoutVisitor::visit(ReturnStm* stm) {
+    if (stm->expr) then(stm->expr);
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(FcallStm* stm) {
+    if (stm->fcall) then(stm->fcall);
+    return 0;
+}
+
+int FrameLayoutVisitor::visit(FunDec* fd)     { return layout(fd); }
+int FrameLayoutVisitor::visit(NumberExp* exp) { return 0; }
+int FrameLayoutVisitor::visit(FloatExp* exp)  { return 0; }
+int FrameLayoutVisitor::visit(BoolExp* exp)   { return 0; }
+int FrameLayoutVisitor::visit(StringExp* exp) { return 0; }
+int FrameLayoutVisitor::visit(StructDec* sd)  { return 0; }
+int FrameLayoutVisitor::visit(Program* prog)  { return 0; }
+
+void CodeGenerator::markLine(uint32_t pos) {
+    if (lines) {
+        LineTable::Location loc = lines->locate(pos);
+        out << "    # linea " << loc.line << ":" << loc.column << "\n";
     }
-    return false;
 }
 
-int CodeGenerator::visit(BinaryExp* exp) {
-    int constVal;
-    if (exp->isConstant(constVal)) {
-        out << "    movq $" << constVal << ", %rax\n";
-        isFloat = false;      
-        isUnsigned = false;   
-        return 0;
+// El AST plano se reconstruye en un arena propio solo para emitir; el
+// calculo de memoria por funcion se hace directamente sobre los arreglos.
+int CodeGenerator::generar(const FlatAst& ast) {
+    Arena arena;
+    ArenaScope scope(arena);
+    Program* prog = ast.raise();
+    typeChecker.type(prog);
+    Canonicalizer().run(prog);
+    symbols.assign(SymbolTable::global().size(), SymbolInfo());
+    for (auto& f : typeChecker.fun_memoria) {
+        info(f.first).frameSlots = f.second;
     }
+    prog->accept(this);
+    return 0;
+}
 
-    exp->left->accept(this);
-    bool leftIsFloat = isFloat;
-    
-    if (leftIsFloat) {
-        out << "    subq $8, %rsp\n";
-        out << "    movsd %xmm0, (%rsp)\n"; 
-    } else {
-        out << "    pushq %rax\n"; 
+int CodeGenerator::generar(Program* prog) {
+    typeChecker.type(prog);
+    Canonicalizer().run(prog);
+    symbols.assign(SymbolTable::global().size(), SymbolInfo());
+    for (auto& f : typeChecker.fun_memoria) {
+        info(f.first).frameSlots = f.second;
+    }
+    prog->accept(this);
+    return 0;
+}
+
+// En postorden con pilas propias; second marca un BinaryExp cuyos hijos
+// ya estan en evalValues
+bool CodeGenerator::evalConstExpr(Exp* e, int& value) {
+    long long v;
+    if (!evalConstExpr(e, v) || v < INT_MIN || v > INT_MAX) return false;
+    value = (int)v;
+    return true;
+}
+
+bool CodeGenerator::evalConstExpr(Exp* e, long long& value) {
+    evalWork.assign(1, {e, false});
+    evalValues.clear();
+    while (!evalWork.empty()) {
+        auto [x, folded] = evalWork.back();
+        evalWork.pop_back();
+        switch (x->kind) {
+        case Exp::NUMBER_EXP:
+            evalValues.push_back(static_cast<NumberExp*>(x)->value);
+            break;
+
+        case Exp::BOOL_EXP:
+            evalValues.push_back(static_cast<BoolExp*>(x)->value ? 1 : 0);
+            break;
+
+        case Exp::ID_EXP: {
+            SymbolInfo& rec = info(static_cast<IdExp*>(x)->sym);
+            if (rec.constEpoch != constEpoch || !rec.isConst) return false;
+            evalValues.push_back(rec.constValue);
+            break;
+        }
+
+        case Exp::BINARY_EXP: {
+            BinaryExp* bin = static_cast<BinaryExp*>(x);
+            if (bin->facts & (BinaryExp::ALWAYS_TRUE | BinaryExp::ALWAYS_FALSE)) {
+                evalValues.push_back((bin->facts & BinaryExp::ALWAYS_TRUE) ? 1 : 0);
+                break;
+            }
+            if (!folded) {
+                evalWork.push_back({bin, true});
+                evalWork.push_back({bin->right, false});
+                evalWork.push_back({bin->left, false});
+                break;
+            }
+            long long rv = evalValues.back();
+            evalValues.pop_back();
+            long long lv = evalValues.back();
+            long long v;
+            if (!Canonicalizer::foldLong(bin->op, lv, rv, v)) return false;
+            evalValues.back() = v;
+            break;
+        }
+
+        default:
+            return false;
+        }
     }
-    bool leftIsUnsigned = isUnsigned;
+    value = evalValues.back();
+    return true;
+}
+
 
-    exp->right->accept(this);
-    bool rightIsFloat = isFloat;
-    bool rightIsUnsigned = isUnsigned;
+// Las operaciones entre constantes ya las plego el Canonicalizer; las
+// comparaciones que resolvio RangeAnalysis no evaluan los operandos
+int CodeGenerator::visit(BinaryExp* exp) {
+    if (exp->facts & (BinaryExp::ALWAYS_TRUE | BinaryExp::ALWAYS_FALSE)) {
+        out << "    movq $" << ((exp->facts & BinaryExp::ALWAYS_TRUE) ? 1 : 0) << ", %rax\n";
+        return 0;
+    }
+    then(exp->left);
+    then([=] {
+        if (exp->left->type == FLOAT_VALUE) {
+            out << "    subq $8, %rsp\n";
+            out << "    movsd %xmm0, (%rsp)\n"; 
+        } else {
+            out << "    pushq %rax\n"; 
+        }
+    });
+    then(exp->right);
+    then([=] { emitBinary(exp); });
+    return 0;
+}
+
+// Con left en la pila y right en %rax / %xmm0
+void CodeGenerator::emitBinary(BinaryExp* exp) {
+    bool leftIsFloat = exp->left->type == FLOAT_VALUE;
+    bool leftIsUnsigned = exp->left->type == UNSIGNED_VALUE;
+    bool rightIsFloat = exp->right->type == FLOAT_VALUE;
+    bool rightIsUnsigned = exp->right->type == UNSIGNED_VALUE;
     
     if (leftIsFloat || rightIsFloat) {
         if (!rightIsFloat) {
@@ -248,23 +594,34 @@ int CodeGenerator::visit(BinaryExp* exp) {
                     default: break;
                 }
                 out << "    movzbq %al, %rax\n";
-                isFloat = false; 
-                return 0;
+                return;
             default: break;
         }
-        isFloat = true;
     } else {
 
         out << "    movq %rax, %rcx\n"; // right en %rcx
         out << "    popq %rax\n";       // left en %rax
         
         bool useUnsigned = leftIsUnsigned || rightIsUnsigned;
+        // Con FITS_32 los 32 bits bajos alcanzan y la instruccion de 32 bits
+        // pone en 0 la mitad alta de %rax
+        bool narrow = exp->facts & BinaryExp::FITS_32;
 
         switch (exp->op) {
-            case PLUS_OP: out << "    addq %rcx, %rax\n"; break;
-            case MINUS_OP: out << "    subq %rcx, %rax\n"; break;
-            case MUL_OP: out << "    imulq %rcx, %rax\n"; break;
+            case PLUS_OP: out << (narrow ? "    addl %ecx, %eax\n" : "    addq %rcx, %rax\n"); break;
+            case MINUS_OP: out << (narrow ? "    subl %ecx, %eax\n" : "    subq %rcx, %rax\n"); break;
+            case MUL_OP: out << (narrow ? "    imull %ecx, %eax\n" : "    imulq %rcx, %rax\n"); break;
             case DIV_OP:
+                if (narrow) {
+                    out << "    xorl %edx, %edx\n";
+                    out << "    divl %ecx\n";
+                    break;
+                }
+                if (exp->facts & BinaryExp::NON_NEGATIVE) {
+                    out << "    xorl %edx, %edx\n";
+                    out << "    divq %rcx\n";
+                    break;
+                }
                 out << "    movq $0, %rdx\n";
                 if (useUnsigned) {
                     out << "    divq %rcx\n";
@@ -311,51 +668,42 @@ int CodeGenerator::visit(BinaryExp* exp) {
                 break;
             default: break;
         }
-        isFloat = false;
-        isUnsigned = useUnsigned;
     }
-    return 0;
 }
 
 
+// 17 digitos significativos: el ensamblador lee exactamente el mismo double
+static string doubleText(double v) {
+    ostringstream s;
+    s << setprecision(17) << v;
+    return s.str();
+}
+
 int CodeGenerator::visit(NumberExp* exp) {
     out << "    movq $" << exp->value << ", %rax\n";
-    isFloat = false;
-    isUnsigned = false; 
     return 0;
 }
 int CodeGenerator::visit(FloatExp* exp) {
     string label = ".FL" + to_string(labelCount++);
     out << ".data\n";
-    out << label << ": .double " << exp->value << "\n";
+    out << label << ": .double " << doubleText(exp->value) << "\n";
     out << ".text\n";
     out << "    movsd " << label << "(%rip), %xmm0\n";
-    isFloat = true;
     return 0;
 }
 int CodeGenerator::visit(IdExp* exp) {
-    if (localVars.check(exp->value)) {
-        int offset = localVars.lookup(exp->value);
-        if (varTypes.count(exp->value) && varTypes[exp->value] == TypeDecl::FLOAT_TYPE) {
-            out << "    movsd " << offset << "(%rbp), %xmm0\n";
-            isFloat = true;
-            isUnsigned = false;
+    bool isFloat = exp->type == FLOAT_VALUE;
+    if (const int* offset = localVars.find(exp->sym)) {
+        if (isFloat) {
+            out << "    movsd " << *offset << "(%rbp), %xmm0\n";
         } else {
-            out << "    movq " << offset << "(%rbp), %rax\n";
-            isFloat = false;
-            if (varTypes.count(exp->value) && varTypes[exp->value] == TypeDecl::UNSIGNED_TYPE) {
-                isUnsigned = true;
-            } else {
-                isUnsigned = false;
-            }
+            out << "    movq " << *offset << "(%rbp), %rax\n";
         }
-    } else if (globalVars.count(exp->value)) {
-        out << "    movq " << exp->value << "(%rip), %rax\n";
-        isFloat = false;
-        if (varTypes.count(exp->value) && varTypes[exp->value] == TypeDecl::UNSIGNED_TYPE) {
-            isUnsigned = true;
+    } else if (info(exp->sym).global) {
+        if (isFloat) {
+            out << "    movsd " << exp->value << "(%rip), %xmm0\n";
         } else {
-            isUnsigned = false;
+            out << "    movq " << exp->value << "(%rip), %rax\n";
         }
     }
     return 0;
@@ -367,7 +715,7 @@ int CodeGenerator::visit(BoolExp* exp) {
 }
 
 int CodeGenerator::visit(StringExp* exp) {
-    string label = getStringLabel(exp->value);
+    string label = getStringLabel(exp->sym);
     out << "    leaq " << label << "(%rip), %rax\n";
     return 0;
 }
@@ -379,7 +727,7 @@ int CodeGenerator::visit(FcallExp* exp) {
 
         auto it = exp->args.begin();
         Exp* formatExp = *it;
-        StringExp* strExp = dynamic_cast<StringExp*>(formatExp);
+        StringExp* strExp = formatExp->as<StringExp>();
         
         if (strExp) {
             string label = "str_" + to_string(labelCount++);
@@ -387,102 +735,124 @@ int CodeGenerator::visit(FcallExp* exp) {
             out << label << ": .string " << strExp->value << "\n";
             out << ".text\n";
             out << "    leaq " << label << "(%rip), %rdi\n"; 
-            
-            it++;
+            printfArgs(exp, 1, 0, 0);
         } else {
-            formatExp->accept(this);
-            out << "    movq %rax, %rdi\n";
-            it++;
+            then(formatExp);
+            then([=] {
+                out << "    movq %rax, %rdi\n";
+                printfArgs(exp, 1, 0, 0);
+            });
         }
+    } else {
+        callArgs(exp, 0, 0);
+    }
+    return 0;
+}
 
-        int gp_reg_idx = 0; 
-        int xmm_reg_idx = 0; 
-        vector<string> gp_regs = {"%rsi", "%rdx", "%rcx", "%r8", "%r9"};
-        
-        for (; it != exp->args.end(); ++it) {
-            (*it)->accept(this); 
-            
-            if (isFloat) {
-                if (xmm_reg_idx < 8) {
-                    if (xmm_reg_idx > 0) {
-                        out << "    movsd %xmm0, %xmm" << xmm_reg_idx << "\n";
-                    }
-                    xmm_reg_idx++;
-                } else {
-             
-                }
-            } else {
-                if (gp_reg_idx < 5) {
-                    out << "    movq %rax, " << gp_regs[gp_reg_idx++] << "\n";
-                } else {
-                    out << "    pushq %rax\n";
+// Argumento i de un printf en adelante; gp y xmm son los registros ya usados
+void CodeGenerator::printfArgs(FcallExp* exp, size_t i, int gp, int xmm) {
+    if (i == exp->args.size()) {
+        out << "    movl $" << xmm << ", %eax\n"; 
+        out << "    call printf@PLT\n";
+        return;
+    }
+    Exp* arg = exp->args[i];
+    then(arg);
+    then([=] {
+        static const char* gp_regs[] = {"%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+        int gp_reg_idx = gp;
+        int xmm_reg_idx = xmm;
+        if (arg->type == FLOAT_VALUE) {
+            if (xmm_reg_idx < 8) {
+                if (xmm_reg_idx > 0) {
+                    out << "    movsd %xmm0, %xmm" << xmm_reg_idx << "\n";
                 }
+                xmm_reg_idx++;
             }
-        }
-        
-        out << "    movl $" << xmm_reg_idx << ", %eax\n"; 
-        out << "    call printf@PLT\n";
-        
-    } else {
-        vector<string> argRegs = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
-        int xmm_idx = 0;
-        
-        for (size_t i = 0; i < exp->args.size() && i < 6; i++) {
-            exp->args[i]->accept(this);
-            if (isFloat) {
-                 out << "    movsd %xmm0, %xmm" << xmm_idx++ << "\n";
+        } else {
+            if (gp_reg_idx < 5) {
+                out << "    movq %rax, " << gp_regs[gp_reg_idx++] << "\n";
             } else {
-                 out << "    movq %rax, " << argRegs[i] << "\n";
+                out << "    pushq %rax\n";
             }
         }
-        out << "    movl $" << xmm_idx << ", %eax\n";
+        printfArgs(exp, i + 1, gp_reg_idx, xmm_reg_idx);
+    });
+}
+
+// Solo los 6 primeros argumentos van en registros
+void CodeGenerator::callArgs(FcallExp* exp, size_t i, int xmm) {
+    if (i == exp->args.size() || i == 6) {
+        out << "    movl $" << xmm << ", %eax\n";
         out << "    call " << exp->fname << "@PLT\n";
+        constEpoch++; // pudo escribir globales
+        return;
     }
-    return 0;
+    Exp* arg = exp->args[i];
+    then(arg);
+    then([=] {
+        static const char* argRegs[] = {"%rdi", "%rsi", "%rdx", "%rcx", "%r8", "%r9"};
+        int xmm_idx = xmm;
+        if (arg->type == FLOAT_VALUE) {
+             out << "    movsd %xmm0, %xmm" << xmm_idx++ << "\n";
+        } else {
+             out << "    movq %rax, " << argRegs[i] << "\n";
+        }
+        callArgs(exp, i + 1, xmm_idx);
+    });
 }
 
 int CodeGenerator::visit(VarDec* vd) {
     for (auto& var : vd->vars) {
-        const string& name = var.name;
-        
-        if (vd->type->kind == TypeDecl::FLOAT_TYPE) {
-            varTypes[name] = TypeDecl::FLOAT_TYPE;
-        } else if (vd->type->kind == TypeDecl::UNSIGNED_TYPE) {
-            varTypes[name] = TypeDecl::UNSIGNED_TYPE;
-        } else {
-            varTypes[name] = TypeDecl::INT_TYPE;
-        }
+        SymbolInfo& rec = info(var.sym);
+        bool declFloat = TypeCheckerVisitor::valueType(vd->type) == FLOAT_VALUE;
 
         if (!inFunction) {
-            globalVars[name] = true;
+            rec.type = TypeCheckerVisitor::valueType(vd->type);
+            if (!rec.global) {
+                rec.global = true;
+                globalOrder.push_back(var.sym);
+            }
             
             if (var.init_value) {
-                int value;
-                if (var.init_value->isConstant(value)) {
-                    globalInitializers[name] = value;
+                long long value;
+                FloatExp* f = var.init_value->as<FloatExp>();
+                if (declFloat && f) {
+                    rec.hasInit = true;
+                    rec.floatInit = f->value;
+                } else if (evalConstExpr(var.init_value, value)) {
+                    rec.hasInit = true;
+                    rec.initValue = value;
+                    rec.floatInit = value;
                 }
             }
         } else {
-            localVars.add_var(name, offset);
+            VarDec::VarInit* v = &var;
+            then([=] {
+                int offset = v->slot;
+                localVars.add_var(v->sym, offset);
             
-            if (var.init_value) {
-                var.init_value->accept(this);
-                
-                if (vd->type->kind == TypeDecl::FLOAT_TYPE && !isFloat) {
-                    out << "    cvtsi2sd %rax, %xmm0\n";
-                    isFloat = true;
-                }
+                if (v->init_value) {
+                    then(v->init_value);
+                    then([=] {
+                        bool initFloat = v->init_value->type == FLOAT_VALUE;
                 
-                if (isFloat) {
-                    out << "    movsd %xmm0, " << offset << "(%rbp)\n";
+                        if (declFloat) {
+                            if (!initFloat) {
+                                out << "    cvtsi2sd %rax, %xmm0\n";
+                            }
+                            out << "    movsd %xmm0, " << offset << "(%rbp)\n";
+                        } else {
+                            if (initFloat) {
+                                out << "    cvttsd2si %xmm0, %rax\n";
+                            }
+                            out << "    movq %rax, " << offset << "(%rbp)\n";
+                        }
+                    });
                 } else {
-                    out << "    movq %rax, " << offset << "(%rbp)\n";
+                    out << "    movq $0, " << offset << "(%rbp)\n";
                 }
-            } else {
-                out << "    movq $0, " << offset << "(%rbp)\n";
-            }
-            
-            offset -= 8;  
+            });
         }
     }
     return 0;
@@ -491,56 +861,40 @@ int CodeGenerator::visit(VarDec* vd) {
 int CodeGenerator::visit(StructDec* sd) { return 0; }
 
 int CodeGenerator::visit(TernaryExp* exp) {
-    bool wantFloat = exprIsFloat(exp->thenExp) || exprIsFloat(exp->elseExp);
+    // Si una rama es float el resultado es float y la otra se convierte
+    bool wantFloat = exp->type == FLOAT_VALUE;
 
     int lbl = labelCounter++;
 
-    exp->condition->accept(this);  
-    if (isFloat) {
-        out << "    cvttsd2si %xmm0, %rax\n";
-        isFloat = false;
-    }
-
-    out << "    cmpq $0, %rax\n";
-    out << "    je tern_else_" << lbl << "\n";
+    then(exp->condition);
+    then([=] {
+        if (exp->condition->type == FLOAT_VALUE) {
+            out << "    cvttsd2si %xmm0, %rax\n";
+        }
 
-    exp->thenExp->accept(this); 
+        out << "    cmpq $0, %rax\n";
+        out << "    je tern_else_" << lbl << "\n";
+    });
 
-    if (wantFloat) {
-        if (!isFloat) {
+    then(exp->thenExp);
+    then([=] {
+        if (wantFloat && exp->thenExp->type != FLOAT_VALUE) {
             out << "    cvtsi2sd %rax, %xmm0\n";
-            isFloat = true;
         }
-    } else {
-        if (isFloat) {
-            out << "    cvttsd2si %xmm0, %rax\n";
-            isFloat = false;
-        }
-    }
 
-    out << "    jmp tern_end_" << lbl << "\n";
+        out << "    jmp tern_end_" << lbl << "\n";
 
-    out << "tern_else_" << lbl << ":\n";
+        out << "tern_else_" << lbl << ":\n";
+    });
 
-    exp->elseExp->accept(this);
-
-    if (wantFloat) {
-        if (!isFloat) {
+    then(exp->elseExp);
+    then([=] {
+        if (wantFloat && exp->elseExp->type != FLOAT_VALUE) {
             out << "    cvtsi2sd %rax, %xmm0\n";
-            isFloat = true;
         }
-    } else {
-        if (isFloat) {
-            out << "    cvttsd2si %xmm0, %rax\n";
-            isFloat = false;
-        }
-    }
-
-    out << "tern_end_" << lbl << ":\n";
 
-    if (!wantFloat) {
-        isUnsigned = false;
-    }
+        out << "tern_end_" << lbl << ":\n";
+    });
     return 0;
 }
 
@@ -548,22 +902,31 @@ int CodeGenerator::visit(TernaryExp* exp) {
 int CodeGenerator::visit(FunDec* fd) {
     inFunction      = true;
     currentFunction = fd->name;
-    isConst.clear();
-    constVal.clear();
+    currentReturn   = TypeCheckerVisitor::valueType(fd->rtype);
+    constEpoch++;
     localVars.clear();
     localVars.add_level();
-    offset = -8;
 
+    markLine(fd->pos);
     out << ".globl " << fd->name << "\n";
     out << fd->name << ":\n";
     out << "    pushq %rbp\n";
     out << "    movq %rsp, %rbp\n";
 
-    int totalSlots = 0;
-    if (fun_memoria.count(fd->name)) {
-        totalSlots = fun_memoria[fd->name];
-    }
+    // El marco va alineado a 16 bytes
+    int totalSlots = frame.layout(fd);
     if (totalSlots % 2 != 0) totalSlots++; 
+    if (frameSizes) {
+        int before = info(fd->sym).frameSlots;
+        if (before % 2 != 0) before++;
+        *frameSizes << fd->name << ": " << before * 8 << " -> " << totalSlots * 8 << " bytes\n";
+    }
+    RangeAnalysis::Stats ranges = RangeAnalysis().run(fd);
+    if (rangeStats) {
+        *rangeStats << fd->name << ": " << ranges.narrowed << "/" << ranges.intOps << " operaciones en 32 bits, "
+                    << ranges.unsignedDivs << "/" << ranges.divisions << " divisiones sin signo, "
+                    << ranges.resolved << "/" << ranges.comparisons << " comparaciones resueltas\n";
+    }
 
     if (totalSlots > 0) {
         out << "    subq $" << (totalSlots * 8) << ", %rsp\n";
@@ -575,21 +938,10 @@ int CodeGenerator::visit(FunDec* fd) {
 
     int nparams = (int)fd->pnames.size();
     for (int i = 0; i < nparams; ++i) {
-        const string& pname = fd->pnames[i];
+        SymbolId pname = fd->psyms[i];
         TypeDecl* ptype = (i < (int)fd->ptypes.size()) ? fd->ptypes[i] : nullptr;
 
-        if (ptype) {
-            if (ptype->kind == TypeDecl::FLOAT_TYPE) {
-                varTypes[pname] = TypeDecl::FLOAT_TYPE;
-            } else if (ptype->kind == TypeDecl::UNSIGNED_TYPE) {
-                varTypes[pname] = TypeDecl::UNSIGNED_TYPE;
-            } else {
-                varTypes[pname] = TypeDecl::INT_TYPE;
-            }
-        } else {
-            varTypes[pname] = TypeDecl::INT_TYPE;
-        }
-
+        int offset = frame.paramSlots[i];
         localVars.add_var(pname, offset);
 
         if (ptype && ptype->kind == TypeDecl::FLOAT_TYPE) {
@@ -601,29 +953,35 @@ int CodeGenerator::visit(FunDec* fd) {
             out << "    movq " << gpArgRegs[gp_idx] << ", " << offset << "(%rbp)\n";
             gp_idx++;
         }
-
-        offset -= 8;
     }
 
     if (fd->body) {
-        fd->body->accept(this);
+        then(fd->body);
     }
 
-    out << ".end_" << fd->name << ":\n";
-    out << "    leave\n";
-    out << "    ret\n";
+    then([=] {
+        out << ".end_" << fd->name << ":\n";
+        out << "    leave\n";
+        out << "    ret\n";
 
-    localVars.remove_level();
-    inFunction      = false;
-    currentFunction.clear();
+        localVars.remove_level();
+        inFunction      = false;
+        currentFunction.clear();
+    });
     return 0;
 }
 int CodeGenerator::visit(AssignStm* stm) {
-    stm->rhs->accept(this); 
+    then(stm->rhs);
+    then([=] { emitAssign(stm); });
+    return 0;
+}
 
-    bool destIsFloat = (varTypes.count(stm->id) && varTypes[stm->id] == TypeDecl::FLOAT_TYPE);
+void CodeGenerator::emitAssign(AssignStm* stm) {
+    SymbolInfo& rec = info(stm->sym);
+    bool destIsFloat = stm->target == FLOAT_VALUE;
+    bool isFloat = stm->rhs->type == FLOAT_VALUE;
 
-    if (globalVars.count(stm->id)) {
+    if (rec.global) {
         if (destIsFloat) {
             if (!isFloat) {
                 out << "    cvtsi2sd %rax, %xmm0\n";
@@ -636,7 +994,7 @@ int CodeGenerator::visit(AssignStm* stm) {
             out << "    movq %rax, " << stm->id << "(%rip)\n";
         }
     } else {
-        int off = localVars.lookup(stm->id);
+        int off = localVars.lookup(stm->sym);
         if (destIsFloat) {
             if (!isFloat) {
                 out << "    cvtsi2sd %rax, %xmm0\n";
@@ -650,15 +1008,12 @@ int CodeGenerator::visit(AssignStm* stm) {
         }
     }
 
+    // rhs puede leer la misma variable: se evalua antes de marcarla
     int v;
-    if (evalConstExpr(stm->rhs, v)) {
-        isConst[stm->id]  = true;
-        constVal[stm->id] = v;
-    } else {
-        isConst[stm->id] = false;
-    }
-
-    return 0;
+    bool known = evalConstExpr(stm->rhs, v);
+    rec.constEpoch = constEpoch;
+    rec.isConst    = known;
+    if (known) rec.constValue = v;
 }
 int CodeGenerator::visit(PrintStm* stm) {
     if (stm->args.empty()) return 0;
@@ -666,7 +1021,7 @@ int CodeGenerator::visit(PrintStm* stm) {
     auto it = stm->args.begin();
     Exp* formatExp = *it;
     
-    StringExp* strExp = dynamic_cast<StringExp*>(formatExp);
+    StringExp* strExp = formatExp->as<StringExp>();
     
     if (strExp) {
         string label = "str_" + to_string(labelCount++);
@@ -680,32 +1035,35 @@ int CodeGenerator::visit(PrintStm* stm) {
             out << "    call printf@PLT\n";
         } else {
             ++it;  
-            (*it)->accept(this);  
-            
-            if (isFloat) {
-                out << "    movsd %xmm0, %xmm0\n"; 
-                out << "    movl $1, %eax\n"; 
-            } else {
-                out << "    movq %rax, %rsi\n";  
-                out << "    movl $0, %eax\n";
-            }
+            Exp* arg = *it;
+            then(arg);
+            then([=] {
+                if (arg->type == FLOAT_VALUE) {
+                    out << "    movsd %xmm0, %xmm0\n"; 
+                    out << "    movl $1, %eax\n"; 
+                } else {
+                    out << "    movq %rax, %rsi\n";  
+                    out << "    movl $0, %eax\n";
+                }
             
-            out << "    leaq " << label << "(%rip), %rdi\n";
-            out << "    call printf@PLT\n";
+                out << "    leaq " << label << "(%rip), %rdi\n";
+                out << "    call printf@PLT\n";
+            });
         }
     } else {
         for (auto arg : stm->args) {
-            arg->accept(this); 
-            
-            if (isFloat) {
-                out << "    leaq print_float_fmt(%rip), %rdi\n";
-                out << "    movl $1, %eax\n"; 
-            } else {
-                out << "    movq %rax, %rsi\n";
-                out << "    leaq print_fmt(%rip), %rdi\n";
-                out << "    movl $0, %eax\n";
-            }
-            out << "    call printf@PLT\n";
+            then(arg);
+            then([=] {
+                if (arg->type == FLOAT_VALUE) {
+                    out << "    leaq print_float_fmt(%rip), %rdi\n";
+                    out << "    movl $1, %eax\n"; 
+                } else {
+                    out << "    movq %rax, %rsi\n";
+                    out << "    leaq print_fmt(%rip), %rdi\n";
+                    out << "    movl $0, %eax\n";
+                }
+                out << "    call printf@PLT\n";
+            });
         }
     }
     
@@ -716,69 +1074,97 @@ int CodeGenerator::visit(IfStm* stm) {
     int constVal;
     if (evalConstExpr(stm->condition, constVal)) {
         if (constVal != 0) {
-            if (stm->thenbody) stm->thenbody->accept(this);
+            if (stm->thenbody) then(stm->thenbody);
         } else {
-            if (stm->elsebody) stm->elsebody->accept(this);
+            if (stm->elsebody) then(stm->elsebody);
         }
         return 0;
     }
 
     int label = labelCounter++;
 
-    stm->condition->accept(this);
-    out << "    cmpq $0, %rax\n";
-    out << "    je else_" << label << "\n";
+    then(stm->condition);
+    then([=] {
+        out << "    cmpq $0, %rax\n";
+        out << "    je else_" << label << "\n";
+    });
 
-    int savedOffset = offset;
-    if (stm->thenbody) stm->thenbody->accept(this);
+    if (stm->thenbody) then(stm->thenbody);
 
-    out << "    jmp endif_" << label << "\n";
-    out << "else_" << label << ":\n";
+    // Las constantes de una rama no valen en la otra ni despues del if
+    then([=] {
+        out << "    jmp endif_" << label << "\n";
+        out << "else_" << label << ":\n";
+        constEpoch++;
+    });
 
-    offset = savedOffset;
-    if (stm->elsebody) stm->elsebody->accept(this);
+    if (stm->elsebody) then(stm->elsebody);
 
-    out << "endif_" << label << ":\n";
+    then([=] {
+        out << "endif_" << label << ":\n";
+        constEpoch++;
+    });
     return 0;
 }
 
 int CodeGenerator::visit(WhileStm* stm) {
     int label = labelCounter++;
     out << "while_" << label << ":\n";
-    stm->condition->accept(this);
-    out << "    cmpq $0, %rax\n";
-    out << "    je endwhile_" << label << "\n";
-    if (stm->body) stm->body->accept(this);
-    out << "    jmp while_" << label << "\n";
-    out << "endwhile_" << label << ":\n";
+    constEpoch++; // se llega tambien desde el final del cuerpo
+    then(stm->condition);
+    then([=] {
+        out << "    cmpq $0, %rax\n";
+        out << "    je endwhile_" << label << "\n";
+    });
+    if (stm->body) then(stm->body);
+    then([=] {
+        out << "    jmp while_" << label << "\n";
+        out << "endwhile_" << label << ":\n";
+        constEpoch++;
+    });
     return 0;
 }
 
 int CodeGenerator::visit(ForStm* stm) {
     int label = labelCounter++;
 
-    if (stm->init) stm->init->accept(this);
+    if (stm->init) then(stm->init);
 
-    out << "for_" << label << ":\n";
+    then([=] {
+        out << "for_" << label << ":\n";
+        constEpoch++;
+    });
     if (stm->condition) {
-        stm->condition->accept(this);
-        out << "    cmpq $0, %rax\n";
-        out << "    je endfor_" << label << "\n";
+        then(stm->condition);
+        then([=] {
+            out << "    cmpq $0, %rax\n";
+            out << "    je endfor_" << label << "\n";
+        });
     }
 
-    if (stm->body) stm->body->accept(this);
-    if (stm->update) stm->update->accept(this);
+    if (stm->body) then(stm->body);
+    if (stm->update) then(stm->update);
 
-    out << "    jmp for_" << label << "\n";
-    out << "endfor_" << label << ":\n";
+    then([=] {
+        out << "    jmp for_" << label << "\n";
+        out << "endfor_" << label << ":\n";
+        constEpoch++;
+    });
     return 0;
 }
 
 int CodeGenerator::visit(ReturnStm* stm) {
     if (stm->expr) {
-        stm->expr->accept(this); 
+        then(stm->expr);
+        then([=] {
+            if (currentReturn == FLOAT_VALUE && stm->expr->type != FLOAT_VALUE) {
+                out << "    cvtsi2sd %rax, %xmm0\n";
+            } else if (currentReturn != FLOAT_VALUE && stm->expr->type == FLOAT_VALUE) {
+                out << "    cvttsd2si %xmm0, %rax\n";
+            }
+        });
     }
-    out << "    jmp .end_" << currentFunction << "\n";
+    then([=] { out << "    jmp .end_" << currentFunction << "\n"; });
     return 0;
 }
 
@@ -789,7 +1175,7 @@ int CodeGenerator::visit(FcallStm* stm) {
         if (stm->fcall->args.empty()) return 0;
 
         Exp* firstArg = stm->fcall->args[0];
-        StringExp* formatExp = dynamic_cast<StringExp*>(firstArg);
+        StringExp* formatExp = firstArg->as<StringExp>();
 
         if (formatExp) {
             string label = "str_" + to_string(labelCount++);
@@ -806,25 +1192,25 @@ int CodeGenerator::visit(FcallStm* stm) {
                 out << "    call printf@PLT\n";
             } else {
                 Exp* arg = stm->fcall->args[1];
-                arg->accept(this);
-
-                if (expectFloat && !isFloat) {
-                    out << "    cvtsi2sd %rax, %xmm0\n";
-                    isFloat = true;
-                }
-                if (expectFloat) {
-                    out << "    movsd %xmm0, %xmm0\n";
-                    out << "    movl $1, %eax\n";
-                } else {
-                    out << "    movq %rax, %rsi\n";
-                    out << "    movl $0, %eax\n";
-                }
-                out << "    leaq " << label << "(%rip), %rdi\n";
-                out << "    call printf@PLT\n";
+                then(arg);
+                then([=] {
+                    if (expectFloat && arg->type != FLOAT_VALUE) {
+                        out << "    cvtsi2sd %rax, %xmm0\n";
+                    }
+                    if (expectFloat) {
+                        out << "    movsd %xmm0, %xmm0\n";
+                        out << "    movl $1, %eax\n";
+                    } else {
+                        out << "    movq %rax, %rsi\n";
+                        out << "    movl $0, %eax\n";
+                    }
+                    out << "    leaq " << label << "(%rip), %rdi\n";
+                    out << "    call printf@PLT\n";
+                });
             }
         }
     } else {
-        stm->fcall->accept(this);
+        then(stm->fcall);
     }
     return 0;
 }
@@ -834,17 +1220,23 @@ int CodeGenerator::visit(FcallStm* stm) {
 int CodeGenerator::visit(Body* body) {
     localVars.add_level();
     for (auto vd : body->vardecs) {
-        vd->accept(this);
+        then([=] {
+            markLine(vd->pos);
+            vd->accept(this);
+        });
     }
     for (auto stm : body->stmts) {
-        stm->accept(this); 
+        then([=] {
+            markLine(stm->pos);
+            stm->accept(this);
+        });
     }
-    localVars.remove_level();
+    then([=] { localVars.remove_level(); });
     return 0;
 }
 
 int CodeGenerator::visit(Program* prog) {
-    globalVars.clear();
+    globalOrder.clear();
 
     // Sección de datos
     out << ".data\n";
@@ -854,24 +1246,80 @@ int CodeGenerator::visit(Program* prog) {
     // Variables globales
     inFunction = false;
     for (auto vd : prog->vardecs) {
-        vd->accept(this);
+        walk(vd);
     }
 
-    for (auto it = globalVars.begin(); it != globalVars.end(); ++it) {
-        if (it->second) {
-            int initValue = 0;
-            if (globalInitializers.count(it->first)) {
-                initValue = globalInitializers[it->first];
-            }
-            out << it->first << ": .quad " << initValue << "\n";
-        }
-    }
+    emitGlobals();
     // Sección de código
     out << ".text\n";
     for (auto fd : prog->fundecs) {
-        fd->accept(this);
+        walk(fd);
     }
 
+    if (stringCounter > 0) {
+        out << ".data\n";
+        emitStringPool();
+    }
     out << ".section .note.GNU-stack,\"\",@progbits\n";
     return 0;
 }
+
+void CodeGenerator::emitGlobals() {
+    for (SymbolId g : globalOrder) {
+        const SymbolInfo& rec = symbols[g];
+        if (rec.type == FLOAT_VALUE) {
+            double value = rec.hasInit ? rec.floatInit : 0;
+            out << SymbolTable::global().name(g) << ": .double " << doubleText(value) << "\n";
+        } else {
+            long long value = rec.hasInit ? rec.initValue : 0;
+            out << SymbolTable::global().name(g) << ": .quad " << value << "\n";
+        }
+    }
+}
+
+// Cadenas usadas como valor (StringExp): una etiqueta por texto distinto
+void CodeGenerator::emitStringPool() {
+    for (SymbolId s = 0; s < symbols.size(); s++) {
+        if (!symbols[s].label.empty()) {
+            out << symbols[s].label << ": .string " << SymbolTable::global().name(s) << "\n";
+        }
+    }
+}
+
+void CodeGenerator::empezar() {
+    globalOrder.clear();
+    symbols.clear();
+    out << ".data\n";
+    out << "print_fmt: .string \"%ld \\n\"\n";
+    out << "print_float_fmt: .string \"%f \\n\"\n";
+    out << ".text\n";
+}
+
+// La tabla global crece mientras se parsea: symbols se extiende antes de
+// cada declaracion
+void CodeGenerator::generarGlobal(VarDec* vd) {
+    symbols.resize(SymbolTable::global().size());
+    inFunction = false;
+    typeChecker.walk(vd);
+    Canonicalizer().run(vd);
+    walk(vd);
+}
+
+bool CodeGenerator::generarFuncion(FunDec* fd) {
+    symbols.resize(SymbolTable::global().size());
+    bool typed = !typeChecker.assumedInt.count(fd->sym) ||
+                 TypeCheckerVisitor::valueType(fd->rtype) == INT_VALUE;
+    typeChecker.fun_memoria.clear();
+    typeChecker.walk(fd);
+    Canonicalizer().run(fd);
+    info(fd->sym).frameSlots = typeChecker.fun_memoria[fd->sym];
+    walk(fd);
+    return typed;
+}
+
+void CodeGenerator::terminar() {
+    out << ".data\n";
+    emitGlobals();
+    emitStringPool();
+    out << ".section .note.GNU-stack,\"\",@progbits\n";
+}
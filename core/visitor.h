@@ -5,7 +5,11 @@
 #include <list>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include "environment.h"
+#include "source.h"
+#include "flatast.h"
+#include "walker.h"
 #include <string>
 #include <ostream>
 
@@ -58,13 +62,94 @@ public:
     virtual int visit(Program* prog) = 0;
 };
 
+// Visitor que recorre con la pila del Walker: cada visit agenda sus hijos
+// con then(hijo) en vez de llamar a accept, y el codigo que va despues de
+// un hijo con then([=] { ... }). La entrada es walk(nodo).
+class WalkingVisitor : public Visitor, public Walker {
+public:
+    using Walker::walk;
+    template <typename Node>
+    void walk(Node* node) {
+        walk([this, node] { node->accept(this); });
+    }
+protected:
+    using Walker::then;
+    template <typename Node>
+    void then(Node* node) {
+        then([this, node] { node->accept(this); });
+    }
+};
 
 
-class TypeCheckerVisitor : public Visitor {
+// Anota en cada Exp su tipo (y en cada AssignStm el de la variable) y
+// cuenta los slots de cada funcion en fun_memoria. Una sola pasada: el
+// codegen lee las anotaciones y no vuelve a deducir tipos.
+class TypeCheckerVisitor : public WalkingVisitor {
+private:
+    unordered_map<SymbolId,ValueType> globalTypes;
+    unordered_map<SymbolId,ValueType> funTypes; // tipo de retorno
+    Environment<ValueType> locals;
+    bool inFunction = false;
+    ValueType lookup(SymbolId sym);
+    void binaryType(BinaryExp* exp);
+    void ternaryType(TernaryExp* exp);
 public:
-    unordered_map<string,int> fun_memoria;
+    unordered_map<SymbolId,int> fun_memoria;
+    unordered_set<SymbolId> assumedInt; // llamadas a funciones aun sin tipo conocido
     int locales;
     int type(Program* program);
+    static ValueType valueType(TypeDecl* t);
+    void declareFunction(TypeDecl* rtype, SymbolId sym) { funTypes[sym] = valueType(rtype); }
+    int visit(BinaryExp* exp) override;
+    int visit(NumberExp* exp) override;
+    int visit(FloatExp* exp) override;
+    int visit(IdExp* exp) override;
+    int visit(BoolExp* exp) override;
+    int visit(StringExp* exp) override;
+    int visit(FcallExp* exp) override;
+    int visit(VarDec* vd) override;
+    int visit(StructDec* sd) override;
+    int visit(FunDec* fd) override;
+    int visit(AssignStm* stm) override;
+    int visit(PrintStm* stm) override;
+    int visit(IfStm* stm) override;
+    int visit(WhileStm* stm) override;
+    int visit(ForStm* stm) override;
+    int visit(ReturnStm* stm) override;
+    int visit(FcallStm* stm) override;
+    int visit(Body* body) override;
+    int visit(Program* prog) override;
+    int visit(TernaryExp* exp) override;
+};
+
+// Ubica las locales de una funcion en el marco. La vida de una variable va
+// de su declaracion a su ultima referencia (lectura o escritura) en orden
+// de fuente, y si se la usa dentro de un bucle que empieza despues de
+// declararla cubre el bucle entero. Las que no se solapan comparten slot.
+class FrameLayoutVisitor : public WalkingVisitor {
+private:
+    struct Range {
+        int start, end;
+        int loop;              // bucle hasta cuyo final sigue viva, o -1
+        VarDec::VarInit* var;  // nullptr: parametro
+    };
+    struct OpenLoop {
+        int id;
+        int start;
+    };
+    vector<Range> ranges;      // en orden de declaracion
+    vector<int> loopEnd;       // por id de bucle
+    vector<OpenLoop> loops;    // bucles abiertos, de afuera hacia adentro
+    Environment<int> scope;    // SymbolId -> indice en ranges
+    int point = 0;
+
+    void use(SymbolId sym);
+    void declare(SymbolId sym, VarDec::VarInit* var);
+    void openLoop();
+    void closeLoop();
+public:
+    vector<int> paramSlots;    // offsets de los parametros de la ultima funcion
+    int layout(FunDec* fd);    // anota VarInit::slot; devuelve los slots del marco
     int visit(BinaryExp* exp) override;
     int visit(NumberExp* exp) override;
     int visit(FloatExp* exp) override;
@@ -87,36 +172,59 @@ public:
     int visit(TernaryExp* exp) override;
 };
 
-class CodeGenerator : public Visitor {
+// Lo que el codegen sabe de cada nombre, en un arreglo denso por SymbolId
+struct SymbolInfo {
+    ValueType type = INT_VALUE; // global: tipo declarado (para emitir sus datos)
+    bool global = false;        // variable global
+    bool hasInit = false;       // global con inicializador constante
+    long long initValue = 0;
+    double floatInit = 0;       // idem, si la global es float
+    uint32_t constEpoch = 0;    // isConst/constValue solo valen mientras no cambie el epoch
+    bool isConst = false;
+    int constValue = 0;
+    int frameSlots = 0;         // funcion: slots de 8 bytes sin compartir (TypeChecker)
+    string label;               // literal de cadena: etiqueta .S<n> ya emitida
+};
+
+class CodeGenerator : public WalkingVisitor {
 private:
     std::ostream& out;
-    unordered_map<string,string> stringLabels;
-    unordered_map<string, int> globalInitializers;
     int labelCount = 0;
     int stringCounter = 0;
-    string getStringLabel(const string& s) {
-        if (stringLabels.count(s)) return stringLabels[s];
-        string label = ".S" + to_string(stringCounter++);
-        stringLabels[s] = label;
-        return label;
+    string getStringLabel(SymbolId s) {
+        SymbolInfo& rec = info(s);
+        if (rec.label.empty()) rec.label = ".S" + to_string(stringCounter++);
+        return rec.label;
     }
+    void emitGlobals();
+    void emitStringPool();
+    void emitBinary(BinaryExp* exp);
+    void emitAssign(AssignStm* stm);
+    void printfArgs(FcallExp* exp, size_t i, int gp, int xmm);
+    void callArgs(FcallExp* exp, size_t i, int xmm);
+    // pilas de evalConstExpr
+    vector<pair<Exp*, bool>> evalWork;
+    vector<long long> evalValues;
 public:
     TypeCheckerVisitor typeChecker;
-    unordered_map<string,int> fun_memoria;
+    FrameLayoutVisitor frame;
+    vector<SymbolInfo> symbols;
+    vector<SymbolId> globalOrder; // globales en orden de declaracion
+    uint32_t constEpoch = 0;      // se incrementa en cada funcion, llamada, rama y bucle
+    // generar() dimensiona symbols con la tabla global antes de recorrer
+    SymbolInfo& info(SymbolId id) { return symbols[id]; }
     Environment<int> localVars;
-    unordered_map<string, bool> globalVars;
-    unordered_map<string, TypeDecl::TypeKind> varTypes;
-    int offset = -8;
     int labelCounter = 0;
     bool inFunction = false;
-    bool isFloat = false; 
-    bool isUnsigned = false; 
     string currentFunction;
+    ValueType currentReturn = INT_VALUE;
+    LineTable* lines = nullptr; // si no es nulo, anota "# linea L:C" en el asm
+    ostream* frameSizes = nullptr; // si no es nulo, reporta el marco de cada funcion
+    ostream* rangeStats = nullptr; // si no es nulo, reporta lo que resolvio RangeAnalysis
+    void markLine(uint32_t pos);
 
-    unordered_map<string, bool> isConst;
-    unordered_map<string, int>  constVal;
-    bool evalConstExpr(Exp* e, int& value);
-    bool exprIsFloat(Exp* e);
+    bool evalConstExpr(Exp* e, long long& value); // en 64 bits, como el programa
+    bool evalConstExpr(Exp* e, int& value);       // idem, si el resultado cabe en int
     CodeGenerator(std::ostream& out) : out(out) {}
     
     int visit(BinaryExp* exp) override;
@@ -144,6 +252,17 @@ public:
     int visit(TernaryExp* exp) override;
     
     int generar(Program* prog);
+    int generar(const FlatAst& ast);
+
+    // Compilacion por declaracion (--stream-compile): cada global y cada
+    // funcion se emiten a medida que se parsean y no se vuelven a leer; los
+    // datos de las globales y las cadenas se escriben en terminar()
+    void empezar();
+    void declararFuncion(TypeDecl* rtype, SymbolId sym) { typeChecker.declareFunction(rtype, sym); }
+    void generarGlobal(VarDec* vd);
+    // false si ya se la llamo asumiendo int y devuelve otro tipo
+    bool generarFuncion(FunDec* fd);
+    void terminar();
 };
 
 #endif // VISITOR_H
\ No newline at end of file
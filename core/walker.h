@@ -0,0 +1,47 @@
+#ifndef WALKER_H
+#define WALKER_H
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Recorrido con pila de trabajo propia, en estilo de continuaciones: un paso
+// no recursa sobre los hijos sino que agenda con then() lo que sigue (los
+// hijos y el codigo que va entre ellos). Lo agendado corre en ese orden y
+// antes que lo que ya estaba en la pila, asi que el orden es el mismo que
+// el del recorrido recursivo, pero la pila nativa no crece con el
+// anidamiento de bloques ni de expresiones.
+class Walker {
+public:
+    typedef function<void()> Step;
+
+    // Corre step y todo lo que agende. Se puede llamar desde un paso: vuelve
+    // cuando termina lo suyo, sin tocar lo pendiente del que lo llamo.
+    void walk(Step step) {
+        size_t base = work.size();
+        work.push_back(move(step));
+        while (work.size() > base) {
+            Step next = move(work.back());
+            work.pop_back();
+            size_t from = pending.size();
+            next();
+            for (size_t i = pending.size(); i > from; i--) {
+                work.push_back(move(pending[i - 1]));
+            }
+            pending.resize(from);
+        }
+    }
+
+protected:
+    void then(Step step) {
+        pending.push_back(move(step));
+    }
+
+private:
+    vector<Step> work;    // por correr, el proximo al final
+    vector<Step> pending; // agendado por el paso en curso
+};
+
+#endif // WALKER_H
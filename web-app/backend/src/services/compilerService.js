@@ -1,270 +1,338 @@
-import { spawn } from 'child_process';
-import fs from 'fs-extra';
-import path from 'path';
-import { fileURLToPath } from 'url';
-import { dirname } from 'path';
-
-const __filename = fileURLToPath(import.meta.url);
-const __dirname = dirname(__filename);
-
-export class CompilerService {
-  constructor() {
-    this.projectRoot = path.resolve(__dirname, '../../../../'); // Root del proyecto
-    this.coreDir = path.join(this.projectRoot, 'core');
-    this.inputsDir = path.join(this.coreDir, 'inputs');      // ✅ inputs está en core/
-    this.outputsDir = path.join(this.coreDir, 'outputs');    // ✅ outputs está en core/
-
-    console.log('📁 Directorios configurados:');
-    console.log('  Project Root:', this.projectRoot);
-    console.log('  Core:', this.coreDir);
-    console.log('  Inputs:', this.inputsDir);
-    console.log('  Outputs:', this.outputsDir);
-  }
-
-  async compileCode(sourceCode, options = {}) {
-    try {
-      // ✅ Asegurar que las carpetas existan
-      await fs.ensureDir(this.inputsDir);
-      await fs.ensureDir(this.outputsDir);
-
-      // 1. Crear archivo temporal
-      const timestamp = Date.now();
-      const inputFile = path.join(this.inputsDir, `web_input_${timestamp}.txt`);
-      await fs.writeFile(inputFile, sourceCode);
-
-      console.log(`📝 Archivo creado: ${inputFile}`);
-
-      // 2. Verificar que el compilador existe
-      const compilerPaths = [
-        path.join(this.coreDir, 'a.out'),
-        path.join(this.coreDir, 'compiler'),
-        path.join(this.coreDir, 'compiler.exe'),
-        path.join(this.coreDir, 'a.exe')
-      ];
-
-      let compilerPath = null;
-      for (const p of compilerPaths) {
-        if (await fs.pathExists(p)) {
-          compilerPath = p;
-          console.log(`✅ Compilador encontrado: ${compilerPath}`);
-          break;
-        }
-      }
-
-      if (!compilerPath) {
-        // Listar archivos en core para debug
-        const coreFiles = await fs.readdir(this.coreDir);
-        console.log('📁 Archivos en core:', coreFiles);
-        throw new Error(`❌ Compilador no encontrado en: ${this.coreDir}\nArchivos disponibles: ${coreFiles.join(', ')}`);
-      }
-
-      // 3. Ejecutar compilador
-      const result = await this.runCompiler(compilerPath, inputFile);
-
-      // 4. Procesar resultados
-      if (result.success) {
-        // ✅ CORREGIDO: Buscar assembly en inputs/ (dentro de core/)
-        const assemblyFile = path.join(this.inputsDir, `web_input_${timestamp}.s`);
-
-        let assembly = '';
-        if (await fs.pathExists(assemblyFile)) {
-          assembly = await fs.readFile(assemblyFile, 'utf8');
-          console.log(`📄 Assembly encontrado: ${assemblyFile}`);
-
-          // Mover a outputs/ (dentro de core/)
-          const destFile = path.join(this.outputsDir, `web_input_${timestamp}.s`);
-          // Usar copy + remove en lugar de move para evitar error EFTYPE
-          await fs.copy(assemblyFile, destFile);
-          await fs.remove(assemblyFile);
-          console.log(`📁 Assembly movido a: ${destFile}`);
-        } else {
-          console.log(`⚠️ No se encontró archivo assembly en: ${assemblyFile}`);
-        }
-
-        return {
-          success: true,
-          tokens: result.tokens,
-          assembly: assembly,
-          ast: result.ast,
-          executionSteps: result.steps,
-          timestamp: timestamp,
-          compilerOutput: result.output
-        };
-      }
-
-      return result;
-    } catch (error) {
-      console.error('❌ Error en compilación:', error);
-      return {
-        success: false,
-        error: error.message
-      };
-    }
-  }
-
-  async runCompiler(compilerPath, inputFile) {
-    return new Promise((resolve) => {
-      console.log(`🔨 Ejecutando: ${compilerPath}`);
-      console.log(`📂 Input file: ${inputFile}`);
-      console.log(`📂 Working dir: ${this.coreDir}`);
-
-      // ✅ IMPORTANTE: Usar ruta relativa desde core/
-      const relativeInputFile = path.relative(this.coreDir, inputFile);
-      console.log(`📂 Relative path: ${relativeInputFile}`);
-
-      const process = spawn(compilerPath, [relativeInputFile], {
-        cwd: this.coreDir,  // Ejecutar desde core/
-        stdio: ['pipe', 'pipe', 'pipe']
-      });
-
-      let stdout = '';
-      let stderr = '';
-
-      process.stdout.on('data', (data) => {
-        stdout += data.toString();
-      });
-
-      process.stderr.on('data', (data) => {
-        stderr += data.toString();
-      });
-
-      process.on('close', (code) => {
-        console.log(`🏁 Compilador terminó con código: ${code}`);
-        console.log('📤 STDOUT length:', stdout.length);
-        console.log('📤 STDOUT preview:', stdout.substring(0, 200));
-        if (stderr) {
-          console.log('📤 STDERR:', stderr.substring(0, 200));
-        }
-
-        resolve({
-          success: code === 0,
-          tokens: this.parseTokens(stdout),
-          ast: this.parseAST(stdout),
-          steps: this.parseExecutionSteps(stdout),
-          output: stdout,
-          error: stderr
-        });
-      });
-
-      process.on('error', (error) => {
-        console.error('❌ Error ejecutando compilador:', error);
-        resolve({
-          success: false,
-          error: `Error ejecutando compilador: ${error.message}`
-        });
-      });
-    });
-  }
-
-  parseTokens(output) {
-    // Extraer tokens de la salida de tu compilador
-    const lines = output.split('\n');
-    const tokens = [];
-
-    for (const line of lines) {
-      const trimmedLine = line.trim();
-      // Buscar diferentes formatos de tokens que podría generar tu compilador
-      if (trimmedLine.includes('TOKEN(') ||
-        trimmedLine.includes('Token:') ||
-        trimmedLine.includes('token') ||
-        (trimmedLine.includes('ID:') || trimmedLine.includes('NUM:') || trimmedLine.includes('OP:'))) {
-        tokens.push(trimmedLine);
-      }
-    }
-
-    console.log(`🏷️ Tokens extraídos: ${tokens.length}`);
-    if (tokens.length > 0) {
-      console.log('🏷️ Primer token:', tokens[0]);
-    }
-
-    return tokens;
-  }
-
-  parseAST(output) {
-    // Extraer información del AST si tu compilador la genera
-    const astLines = output.split('\n').filter(line =>
-      line.includes('AST') ||
-      line.includes('Node') ||
-      line.includes('Expression') ||
-      line.includes('Statement')
-    );
-
-    return {
-      message: 'AST parsing implementado',
-      nodes: astLines,
-      hasAST: astLines.length > 0
-    };
-  }
-
-  parseExecutionSteps(output) {
-    // Extraer pasos de ejecución del intérprete
-    const lines = output.split('\n');
-    const steps = [];
-
-    for (const line of lines) {
-      const trimmed = line.trim();
-      if (trimmed.includes('=') ||
-        trimmed.includes('printf') ||
-        trimmed.includes('->') ||
-        trimmed.includes('Executing') ||
-        trimmed.includes('Result:')) {
-        steps.push({
-          line: trimmed,
-          timestamp: new Date().toISOString()
-        });
-      }
-    }
-
-    console.log(`⚡ Execution steps: ${steps.length}`);
-    return steps;
-  }
-
-  async isAvailable() {
-    const compilerPaths = [
-      path.join(this.coreDir, 'a.out'),
-      path.join(this.coreDir, 'compiler'),
-      path.join(this.coreDir, 'compiler.exe'),
-      path.join(this.coreDir, 'a.exe')
-    ];
-
-    for (const p of compilerPaths) {
-      if (await fs.pathExists(p)) {
-        console.log(`✅ Compilador disponible: ${p}`);
-        return true;
-      }
-    }
-
-    console.log('❌ No se encontró compilador en ninguna ubicación');
-    return false;
-  }
-
-  // ✅ NUEVO: Método para diagnosticar el entorno
-  async diagnose() {
-    const diagnosis = {
-      projectRoot: this.projectRoot,
-      coreDir: this.coreDir,
-      inputsDir: this.inputsDir,
-      outputsDir: this.outputsDir,
-      compilerAvailable: await this.isAvailable(),
-      directories: {},
-      files: {}
-    };
-
-    // Verificar directorios
-    diagnosis.directories.coreExists = await fs.pathExists(this.coreDir);
-    diagnosis.directories.inputsExists = await fs.pathExists(this.inputsDir);
-    diagnosis.directories.outputsExists = await fs.pathExists(this.outputsDir);
-
-    // Listar archivos
-    try {
-      if (diagnosis.directories.coreExists) {
-        const coreFiles = await fs.readdir(this.coreDir);
-        diagnosis.files.core = coreFiles;
-      }
-    } catch (e) {
-      diagnosis.files.coreError = e.message;
-    }
-
-    return diagnosis;
-  }
+import { spawn } from 'child_process';
+import fs from 'fs-extra';
+import path from 'path';
+import { fileURLToPath } from 'url';
+import { dirname } from 'path';
+import { readBinaryTokens, formatToken } from './tokenReader.js';
+
+const __filename = fileURLToPath(import.meta.url);
+const __dirname = dirname(__filename);
+
+// Tope de ast_cache/: snapshots de mas de un dia se borran y, si aun asi pasa
+// de AST_CACHE_MAX_BYTES, se borran los mas viejos primero
+const AST_CACHE_MAX_BYTES = 64 * 1024 * 1024;
+const AST_CACHE_MAX_AGE_MS = 24 * 60 * 60 * 1000;
+
+export class CompilerService {
+  constructor() {
+    this.projectRoot = path.resolve(__dirname, '../../../../'); // Root del proyecto
+    this.coreDir = path.join(this.projectRoot, 'core');
+    this.inputsDir = path.join(this.coreDir, 'inputs');      // ✅ inputs está en core/
+    this.outputsDir = path.join(this.coreDir, 'outputs');    // ✅ outputs está en core/
+    this.astCacheDir = path.join(this.coreDir, 'ast_cache');
+    this.pruning = null;
+
+    console.log('📁 Directorios configurados:');
+    console.log('  Project Root:', this.projectRoot);
+    console.log('  Core:', this.coreDir);
+    console.log('  Inputs:', this.inputsDir);
+    console.log('  Outputs:', this.outputsDir);
+  }
+
+  async compileCode(sourceCode, options = {}) {
+    try {
+      // ✅ Asegurar que las carpetas existan
+      await fs.ensureDir(this.inputsDir);
+      await fs.ensureDir(this.outputsDir);
+
+      // 1. Crear archivo temporal
+      const timestamp = Date.now();
+      const inputFile = path.join(this.inputsDir, `web_input_${timestamp}.txt`);
+      await fs.writeFile(inputFile, sourceCode);
+
+      console.log(`📝 Archivo creado: ${inputFile}`);
+
+      // 2. Verificar que el compilador existe
+      const compilerPaths = [
+        path.join(this.coreDir, 'a.out'),
+        path.join(this.coreDir, 'compiler'),
+        path.join(this.coreDir, 'compiler.exe'),
+        path.join(this.coreDir, 'a.exe')
+      ];
+
+      let compilerPath = null;
+      for (const p of compilerPaths) {
+        if (await fs.pathExists(p)) {
+          compilerPath = p;
+          console.log(`✅ Compilador encontrado: ${compilerPath}`);
+          break;
+        }
+      }
+
+      if (!compilerPath) {
+        // Listar archivos en core para debug
+        const coreFiles = await fs.readdir(this.coreDir);
+        console.log('📁 Archivos en core:', coreFiles);
+        throw new Error(`❌ Compilador no encontrado en: ${this.coreDir}\nArchivos disponibles: ${coreFiles.join(', ')}`);
+      }
+
+      // 3. Ejecutar compilador
+      const result = await this.runCompiler(compilerPath, inputFile);
+
+      // Tokens desde el volcado binario (sin parsear texto con regex)
+      const tokensFile = path.join(this.inputsDir, `web_input_${timestamp}_tokens.bin`);
+      if (await fs.pathExists(tokensFile)) {
+        const tokens = readBinaryTokens(await fs.readFile(tokensFile), sourceCode);
+        result.tokens = tokens.map(formatToken);
+        result.tokenList = tokens;
+        await fs.remove(tokensFile);
+      }
+
+      // El snapshot de esta compilacion ya esta escrito: recortar el cache
+      await this.pruneAstCache();
+
+      // 4. Procesar resultados
+      if (result.success) {
+        // ✅ CORREGIDO: Buscar assembly en inputs/ (dentro de core/)
+        const assemblyFile = path.join(this.inputsDir, `web_input_${timestamp}.s`);
+
+        let assembly = '';
+        if (await fs.pathExists(assemblyFile)) {
+          assembly = await fs.readFile(assemblyFile, 'utf8');
+          console.log(`📄 Assembly encontrado: ${assemblyFile}`);
+
+          // Mover a outputs/ (dentro de core/)
+          const destFile = path.join(this.outputsDir, `web_input_${timestamp}.s`);
+          // Usar copy + remove en lugar de move para evitar error EFTYPE
+          await fs.copy(assemblyFile, destFile);
+          await fs.remove(assemblyFile);
+          console.log(`📁 Assembly movido a: ${destFile}`);
+        } else {
+          console.log(`⚠️ No se encontró archivo assembly en: ${assemblyFile}`);
+        }
+
+        return {
+          success: true,
+          tokens: result.tokens,
+          tokenList: result.tokenList,
+          assembly: assembly,
+          ast: result.ast,
+          executionSteps: result.steps,
+          timestamp: timestamp,
+          compilerOutput: result.output
+        };
+      }
+
+      return result;
+    } catch (error) {
+      console.error('❌ Error en compilación:', error);
+      return {
+        success: false,
+        error: error.message
+      };
+    }
+  }
+
+  async runCompiler(compilerPath, inputFile) {
+    return new Promise((resolve) => {
+      console.log(`🔨 Ejecutando: ${compilerPath}`);
+      console.log(`📂 Input file: ${inputFile}`);
+      console.log(`📂 Working dir: ${this.coreDir}`);
+
+      // ✅ IMPORTANTE: Usar ruta relativa desde core/
+      const relativeInputFile = path.relative(this.coreDir, inputFile);
+      console.log(`📂 Relative path: ${relativeInputFile}`);
+
+      // ast_cache/: ASTs ya parseados, por contenido (un reenvio del mismo
+      // codigo no vuelve a parsear); pruneAstCache lo mantiene acotado
+      const process = spawn(compilerPath, ['--tokens=binary', '--ast-cache=ast_cache', relativeInputFile], {
+        cwd: this.coreDir,  // Ejecutar desde core/
+        stdio: ['pipe', 'pipe', 'pipe']
+      });
+
+      let stdout = '';
+      let stderr = '';
+
+      process.stdout.on('data', (data) => {
+        stdout += data.toString();
+      });
+
+      process.stderr.on('data', (data) => {
+        stderr += data.toString();
+      });
+
+      process.on('close', (code) => {
+        console.log(`🏁 Compilador terminó con código: ${code}`);
+        console.log('📤 STDOUT length:', stdout.length);
+        console.log('📤 STDOUT preview:', stdout.substring(0, 200));
+        if (stderr) {
+          console.log('📤 STDERR:', stderr.substring(0, 200));
+        }
+
+        resolve({
+          success: code === 0,
+          tokens: this.parseTokens(stdout),
+          ast: this.parseAST(stdout),
+          steps: this.parseExecutionSteps(stdout),
+          output: stdout,
+          error: stderr
+        });
+      });
+
+      process.on('error', (error) => {
+        console.error('❌ Error ejecutando compilador:', error);
+        resolve({
+          success: false,
+          error: `Error ejecutando compilador: ${error.message}`
+        });
+      });
+    });
+  }
+
+  // Una sola poda a la vez; las compilaciones que llegan mientras tanto
+  // esperan la que esta en curso
+  async pruneAstCache() {
+    if (!this.pruning) {
+      this.pruning = this.pruneAstCacheNow().finally(() => {
+        this.pruning = null;
+      });
+    }
+    return this.pruning;
+  }
+
+  async pruneAstCacheNow() {
+    try {
+      if (!(await fs.pathExists(this.astCacheDir))) return;
+
+      const now = Date.now();
+      const entries = [];
+      for (const name of await fs.readdir(this.astCacheDir)) {
+        const file = path.join(this.astCacheDir, name);
+        const stat = await fs.stat(file).catch(() => null);
+        if (!stat || !stat.isFile()) continue;
+        // Un .tmp reciente es un snapshot que otro compilador esta escribiendo
+        if (name.includes('.tmp') && now - stat.mtimeMs < AST_CACHE_MAX_AGE_MS) continue;
+        entries.push({ file, size: stat.size, mtime: stat.mtimeMs });
+      }
+
+      entries.sort((a, b) => a.mtime - b.mtime);
+      let total = entries.reduce((sum, e) => sum + e.size, 0);
+      let removed = 0;
+      for (const e of entries) {
+        if (total <= AST_CACHE_MAX_BYTES && now - e.mtime < AST_CACHE_MAX_AGE_MS) break;
+        await fs.remove(e.file);
+        total -= e.size;
+        removed++;
+      }
+
+      if (removed > 0) {
+        console.log(`🧹 ast_cache: ${removed} snapshots borrados (${total} bytes quedan)`);
+      }
+    } catch (error) {
+      // El cache es opcional: una poda fallida no rompe la compilacion
+      console.error('⚠️ Error podando ast_cache:', error.message);
+    }
+  }
+
+  parseTokens(output) {
+    // Extraer tokens de la salida de tu compilador
+    const lines = output.split('\n');
+    const tokens = [];
+
+    for (const line of lines) {
+      const trimmedLine = line.trim();
+      // Buscar diferentes formatos de tokens que podría generar tu compilador
+      if (trimmedLine.includes('TOKEN(') ||
+        trimmedLine.includes('Token:') ||
+        trimmedLine.includes('token') ||
+        (trimmedLine.includes('ID:') || trimmedLine.includes('NUM:') || trimmedLine.includes('OP:'))) {
+        tokens.push(trimmedLine);
+      }
+    }
+
+    console.log(`🏷️ Tokens extraídos: ${tokens.length}`);
+    if (tokens.length > 0) {
+      console.log('🏷️ Primer token:', tokens[0]);
+    }
+
+    return tokens;
+  }
+
+  parseAST(output) {
+    // Extraer información del AST si tu compilador la genera
+    const astLines = output.split('\n').filter(line =>
+      line.includes('AST') ||
+      line.includes('Node') ||
+      line.includes('Expression') ||
+      line.includes('Statement')
+    );
+
+    return {
+      message: 'AST parsing implementado',
+      nodes: astLines,
+      hasAST: astLines.length > 0
+    };
+  }
+
+  parseExecutionSteps(output) {
+    // Extraer pasos de ejecución del intérprete
+    const lines = output.split('\n');
+    const steps = [];
+
+    for (const line of lines) {
+      const trimmed = line.trim();
+      if (trimmed.includes('=') ||
+        trimmed.includes('printf') ||
+        trimmed.includes('->') ||
+        trimmed.includes('Executing') ||
+        trimmed.includes('Result:')) {
+        steps.push({
+          line: trimmed,
+          timestamp: new Date().toISOString()
+        });
+      }
+    }
+
+    console.log(`⚡ Execution steps: ${steps.length}`);
+    return steps;
+  }
+
+  async isAvailable() {
+    const compilerPaths = [
+      path.join(this.coreDir, 'a.out'),
+      path.join(this.coreDir, 'compiler'),
+      path.join(this.coreDir, 'compiler.exe'),
+      path.join(this.coreDir, 'a.exe')
+    ];
+
+    for (const p of compilerPaths) {
+      if (await fs.pathExists(p)) {
+        console.log(`✅ Compilador disponible: ${p}`);
+        return true;
+      }
+    }
+
+    console.log('❌ No se encontró compilador en ninguna ubicación');
+    return false;
+  }
+
+  // ✅ NUEVO: Método para diagnosticar el entorno
+  async diagnose() {
+    const diagnosis = {
+      projectRoot: this.projectRoot,
+      coreDir: this.coreDir,
+      inputsDir: this.inputsDir,
+      outputsDir: this.outputsDir,
+      compilerAvailable: await this.isAvailable(),
+      directories: {},
+      files: {}
+    };
+
+    // Verificar directorios
+    diagnosis.directories.coreExists = await fs.pathExists(this.coreDir);
+    diagnosis.directories.inputsExists = await fs.pathExists(this.inputsDir);
+    diagnosis.directories.outputsExists = await fs.pathExists(this.outputsDir);
+
+    // Listar archivos
+    try {
+      if (diagnosis.directories.coreExists) {
+        const coreFiles = await fs.readdir(this.coreDir);
+        diagnosis.files.core = coreFiles;
+      }
+    } catch (e) {
+      diagnosis.files.coreError = e.message;
+    }
+
+    return diagnosis;
+  }
 }
\ No newline at end of file
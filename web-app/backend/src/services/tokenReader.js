@@ -0,0 +1,53 @@
+// Lector del volcado binario de tokens (<archivo>_tokens.bin) que genera
+// el compilador con --tokens=binary. Formato (ver core/scanner.h):
+//   "TOKB" + version (1 byte)
+//   por token: tipo (1 byte), varint delta desde el token anterior, varint longitud
+
+// Mismo orden que Token::Type en core/token.h
+export const TOKEN_TYPES = [
+  'LPAREN', 'RPAREN', 'LBRACE', 'RBRACE', 'SEMICOL', 'COMA',
+  'PLUS', 'MINUS', 'MUL', 'DIV', 'ASSIGN', 'LT', 'LE', 'GT', 'GE', 'EQ', 'NE',
+  'NUM', 'FLOAT_NUM', 'ID', 'STRING',
+  'IF', 'ELSE', 'WHILE', 'FOR', 'RETURN', 'PRINTF', 'TRUE', 'FALSE',
+  'UNSIGNED', 'STRUCT', 'INT', 'FLOAT', 'QUESTION', 'COLON', 'INCLUDE', 'PREPROCESSOR',
+  'ERR', 'END'
+];
+
+export function readBinaryTokens(buffer, sourceCode) {
+  if (buffer.length < 5 || buffer.toString('latin1', 0, 4) !== 'TOKB' || buffer[4] !== 1) {
+    throw new Error('Formato de tokens binario no reconocido');
+  }
+
+  // Los offsets son en bytes sobre el archivo fuente
+  const source = Buffer.from(sourceCode, 'utf8');
+  const tokens = [];
+  let pos = 5;
+  let offset = 0;
+
+  const readVarint = () => {
+    let value = 0;
+    let shift = 0;
+    let byte;
+    do {
+      byte = buffer[pos++];
+      value += (byte & 0x7f) * 2 ** shift;
+      shift += 7;
+    } while (byte & 0x80);
+    return value;
+  };
+
+  while (pos < buffer.length) {
+    const type = TOKEN_TYPES[buffer[pos++]] ?? 'UNKNOWN';
+    offset += readVarint();
+    const length = readVarint();
+    const text = source.toString('utf8', offset, offset + length);
+    tokens.push({ type, text, offset, length });
+  }
+
+  return tokens;
+}
+
+// Misma representacion que el volcado de texto: TOKEN(TIPO, "texto")
+export function formatToken(token) {
+  return token.type === 'END' ? 'TOKEN(END)' : `TOKEN(${token.type}, "${token.text}")`;
+}